@@ -0,0 +1,78 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "h264_parser.hpp"
+#include "rtp_packetizer.hpp"
+
+// usage: packetizer_bench [file.h264] [mtu]
+int main(int argc, char *argv[])
+{
+    const char *filename = argc > 1 ? argv[1] : "example/dragon.h264";
+    const int64_t mtu = argc > 2 ? atoll(argv[2]) : DEFAULT_PATH_MTU;
+
+    H264Parser h264_file(filename);
+    const H264Index &index = h264_file.get_index();
+    std::vector<std::vector<NalUnit>> accessUnits(index.get_frame_count());
+    for (int64_t frame = 0; frame < index.get_frame_count(); frame++) {
+        auto cur_frame = h264_file.get_frame(frame);
+        H264Parser::split_nal_units(cur_frame.first, cur_frame.second, accessUnits[frame]);
+    }
+    if (accessUnits.empty()) {
+        fprintf(stderr, "no NAL units in %s\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    RtpPacketizer packetizer(mtu);
+    RtpPacket rtpPack{RtpHeader(0, 0, 0)};
+
+    int64_t packets = 0;
+    int64_t bytes = 0;
+    int64_t maxPacketLen = 0;
+    auto sink = [&packets, &bytes, &maxPacketLen](RtpPacket &, int64_t headLen,
+                                                  const uint8_t *, int64_t payloadLen) {
+        const int64_t packetLen = headLen + payloadLen;
+        packets++;
+        bytes += packetLen;
+        if (packetLen > maxPacketLen)
+            maxPacketLen = packetLen;
+        return packetLen;
+    };
+
+    fprintf(stdout, "file            : %s\n", filename);
+    fprintf(stdout, "mtu             : %ld (max payload %ld)\n",
+            packetizer.get_mtu(), packetizer.get_max_payload_size());
+    fprintf(stdout, "access units    : %zu, nal units: %ld\n",
+            accessUnits.size(), index.get_nal_count());
+
+    // STAP-A 없이, 그리고 STAP-A로 묶어서 각각 잰다
+    for (const bool aggregation : {false, true}) {
+        packetizer.set_aggregation(aggregation);
+        PacketizerStats stats;
+        for (const auto &au : accessUnits)
+            packetizer.packetize_access_unit(rtpPack, au, sink, &stats);
+
+        packets = 0;
+        bytes = 0;
+        int64_t passes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        do {
+            for (const auto &au : accessUnits)
+                packetizer.packetize_access_unit(rtpPack, au, sink);
+            passes++;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < 1.0 || passes < 3);
+
+        fprintf(stdout, "---- %s\n", aggregation ? "STAP-A" : "single NAL / FU-A");
+        stats.print("packetizer");
+        fprintf(stdout, "packets / pass  : %ld\n", packets / passes);
+        fprintf(stdout, "max packet len  : %ld\n", maxPacketLen);
+        fprintf(stdout, "packets/s       : %.0f\n", packets / elapsed);
+        fprintf(stdout, "bytes/s         : %.0f (%.1f MB/s)\n",
+                bytes / elapsed, bytes / elapsed / (1024 * 1024));
+    }
+    return 0;
+}
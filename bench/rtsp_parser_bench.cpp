@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "rtsp_parser.hpp"
+#include "common.hpp"
+
+// usage: rtsp_parser_bench [recv chunk bytes]
+// 수백 클라이언트의 keepalive처럼 짧은 요청이 이어 붙어 오는 스트림을 recv 크기만큼 잘라 넣는다
+namespace {
+
+std::string make_stream(int64_t requests)
+{
+    const char *url = "rtsp://192.168.0.10:8554/";
+    std::string stream;
+    char request[512];
+    for (int64_t i = 0; i < requests; i++) {
+        if (i % 3 == 2) {
+            snprintf(request, sizeof(request),
+                     "OPTIONS %s RTSP/1.0\r\n"
+                     "CSeq: %ld\r\n"
+                     "User-Agent: LibVLC/3.0.20 (LIVE555 Streaming Media v2016.11.28)\r\n\r\n",
+                     url, i + 1);
+        } else {
+            snprintf(request, sizeof(request),
+                     "GET_PARAMETER %s RTSP/1.0\r\n"
+                     "CSeq: %ld\r\n"
+                     "User-Agent: LibVLC/3.0.20 (LIVE555 Streaming Media v2016.11.28)\r\n"
+                     "Session: rpi5_picamera\r\n"
+                     "Content-Length: 0\r\n\r\n",
+                     url, i + 1);
+        }
+        stream += request;
+    }
+    return stream;
+}
+
+// 이전 read_client: 요청마다 처음부터 빈 줄을 찾고 sscanf/strstr로 해석한 뒤 memmove 한다
+int64_t parse_legacy(char *recvBuf, int64_t &recvLen, int64_t &cseqSum)
+{
+    int64_t requests = 0;
+    recvBuf[recvLen] = 0;
+    while (true) {
+        char *headerEnd = strstr(recvBuf, "\r\n\r\n");
+        if (headerEnd == nullptr)
+            break;
+        int64_t requestLen = headerEnd + 4 - recvBuf;
+        char saved = recvBuf[requestLen];
+        recvBuf[requestLen] = 0;
+
+        int contentLen = 0;
+        char *contentLenPtr = strstr(recvBuf, "Content-Length:");
+        if (contentLenPtr != nullptr)
+            sscanf(contentLenPtr, "Content-Length: %d", &contentLen);
+        if (contentLen < 0 || requestLen + contentLen > recvLen) {
+            recvBuf[requestLen] = saved;
+            break;
+        }
+
+        char method[16]{0};
+        char url[256]{0};
+        char version[16]{0};
+        int cseq = 0;
+        sscanf(recvBuf, "%15s %255s %15s", method, url, version);
+        const char *cseqPtr = strstr(recvBuf, "CSeq:");
+        if (cseqPtr)
+            sscanf(cseqPtr, "CSeq: %d", &cseq);
+        cseqSum += cseq + (method[0] == 'G');
+        requests++;
+
+        recvBuf[requestLen] = saved;
+        requestLen += contentLen;
+        memmove(recvBuf, recvBuf + requestLen, recvLen - requestLen);
+        recvLen -= requestLen;
+        recvBuf[recvLen] = 0;
+    }
+    return requests;
+}
+
+int64_t parse_incremental(RtspParser &parser, char *recvBuf, int64_t &recvLen, int64_t &cseqSum)
+{
+    RtspRequest request;
+    int64_t requests = 0;
+    int64_t pos = 0;
+    while (pos < recvLen) {
+        int64_t consumed = 0;
+        if (parser.parse(recvBuf + pos, recvLen - pos, request, consumed)
+            != RtspParser::Result::REQUEST)
+            break;
+        cseqSum += request.cseq + request.method.equals("GET_PARAMETER");
+        requests++;
+        pos += consumed;
+    }
+    memmove(recvBuf, recvBuf + pos, recvLen - pos);
+    recvLen -= pos;
+    return requests;
+}
+
+template <typename Parse>
+void run(const char *name, const std::string &stream, const int64_t chunk, Parse parse)
+{
+    char recvBuf[RTSP_RECV_BUF_SIZE + 1];
+    int64_t requests = 0;
+    int64_t cseqSum = 0;
+    int64_t passes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        int64_t recvLen = 0;
+        for (int64_t offset = 0; offset < int64_t(stream.size()); offset += chunk) {
+            const int64_t len = std::min<int64_t>(chunk, stream.size() - offset);
+            memcpy(recvBuf + recvLen, stream.data() + offset, len);
+            recvLen += len;
+            requests += parse(recvBuf, recvLen, cseqSum);
+        }
+        passes++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 1.0);
+
+    fprintf(stdout, "  %-12s: %7.2f M requests/s (%ld requests/pass, checksum %ld)\n",
+            name, requests / elapsed / 1e6, requests / passes, cseqSum / passes);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const int64_t chunk = argc > 1 ? atoll(argv[1]) : 1400;
+    if (chunk <= 0 || chunk > RTSP_RECV_BUF_SIZE / 2) {
+        fprintf(stderr, "chunk must be 1..%ld bytes\n", RTSP_RECV_BUF_SIZE / 2);
+        return EXIT_FAILURE;
+    }
+
+    const std::string stream = make_stream(10000);
+    fprintf(stdout, "%zu bytes of pipelined keepalives, %ld bytes per recv\n", stream.size(), chunk);
+    run("sscanf", stream, chunk, [](char *buf, int64_t &len, int64_t &sum) {
+        return parse_legacy(buf, len, sum);
+    });
+    RtspParser parser;
+    run("RtspParser", stream, chunk, [&parser](char *buf, int64_t &len, int64_t &sum) {
+        return parse_incremental(parser, buf, len, sum);
+    });
+    return 0;
+}
\ No newline at end of file
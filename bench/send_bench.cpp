@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "h264_parser.hpp"
+#include "rtp_packetizer.hpp"
+#include "rtp_sender.hpp"
+
+// usage: send_bench [file.h264] [mtu] [seconds]
+// 루프백으로 같은 스트림을 sendto / sendmmsg / UDP GSO 모드로 보내고 비교한다
+int main(int argc, char *argv[])
+{
+    const char *filename = argc > 1 ? argv[1] : "example/dragon.h264";
+    const int64_t mtu = argc > 2 ? atoll(argv[2]) : DEFAULT_PATH_MTU;
+    const double seconds = argc > 3 ? atof(argv[3]) : 1.0;
+
+    H264Parser h264_file(filename);
+    std::vector<std::pair<const uint8_t *, int64_t>> nals;
+    int64_t offset = 0;
+    while (true) {
+        auto cur_frame = h264_file.get_next_frame(offset);
+        if (cur_frame.second <= 0)
+            break;
+        const int64_t start_code_len = H264Parser::is_start_code(cur_frame.first,
+                                       cur_frame.second, 4) ? 4 : 3;
+        nals.emplace_back(cur_frame.first + start_code_len,
+                          cur_frame.second - start_code_len);
+    }
+    if (nals.empty()) {
+        fprintf(stderr, "no NAL units in %s\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    // 받는 쪽은 읽지 않는다. 수신 버퍼가 차면 커널이 버린다
+    int recvfd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(recvfd, reinterpret_cast<sockaddr *>(&to), sizeof(to)) < 0) {
+        perror("bind");
+        return EXIT_FAILURE;
+    }
+    socklen_t addrLen = sizeof(to);
+    getsockname(recvfd, reinterpret_cast<sockaddr *>(&to), &addrLen);
+
+    int sendfd = socket(AF_INET, SOCK_DGRAM, 0);
+    RtpPacketizer packetizer(mtu);
+
+    const std::pair<SendMode, const char *> modes[] = {
+        {SendMode::SENDTO, "sendto"},
+        {SendMode::SENDMMSG, "sendmmsg"},
+        {SendMode::GSO, "gso"},
+    };
+
+    fprintf(stdout, "file: %s, mtu: %ld, nal units: %zu\n",
+            filename, packetizer.get_mtu(), nals.size());
+    for (const auto &mode : modes) {
+        RtpSender sender(mode.first);
+        RtpSendStats stats;
+        RtpPacket rtpPack{RtpHeader(0, 0, 0)};
+
+        const auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        do {
+            for (const auto &nal : nals) {
+                packetizer.packetize(rtpPack, nal.first, nal.second,
+                                     [&sender](RtpPacket &pack, int64_t headLen,
+                                               const uint8_t *payload, int64_t payloadLen) {
+                    sender.push(pack.get_packet(), headLen, payload, payloadLen);
+                    pack.advance(3000);
+                    return headLen + payloadLen;
+                });
+                sender.flush(sendfd, to, stats);
+            }
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < seconds);
+
+        fprintf(stdout, "%-9s: %10.0f packets/s, %8.1f MB/s, %.2f syscalls/frame%s\n",
+                mode.second, stats.packets / elapsed,
+                stats.bytes / elapsed / (1024 * 1024), stats.syscalls_per_frame(),
+                mode.first == SendMode::GSO && !sender.is_gso_available()
+                ? " (fell back to sendmmsg)" : "");
+    }
+
+    close(sendfd);
+    close(recvfd);
+    return 0;
+}
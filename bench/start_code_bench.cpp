@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "start_code_scanner.hpp"
+
+// usage: start_code_bench [file.h264] [synthetic MB]
+namespace {
+
+std::vector<uint8_t> read_file(const char *filename)
+{
+    std::vector<uint8_t> data;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return data;
+    struct stat file_stat;
+    fstat(fd, &file_stat);
+    data.resize(file_stat.st_size);
+    if (read(fd, data.data(), data.size()) != file_stat.st_size)
+        data.clear();
+    close(fd);
+    return data;
+}
+
+// emulation prevention이 적용된 H.264처럼 NAL 내부에는 00 00 0x(x <= 3)가 없도록 만든다
+std::vector<uint8_t> make_synthetic(int64_t size)
+{
+    std::vector<uint8_t> data(size);
+    std::mt19937 rng(20001102);
+    int zeros = 0;
+    for (int64_t i = 0; i < size; i++) {
+        if (i % (64 * 1024) == 0 && i + 4 <= size) {
+            data[i] = data[i + 1] = data[i + 2] = 0x00;
+            data[i + 3] = 0x01;
+            i += 3;
+            zeros = 0;
+            continue;
+        }
+        uint8_t byte = (rng() % 8 == 0) ? 0x00 : uint8_t(rng());
+        if (zeros >= 2 && byte <= 0x03)
+            byte = 0x03;
+        zeros = byte == 0x00 ? zeros + 1 : 0;
+        data[i] = byte;
+    }
+    return data;
+}
+
+// 원래 H264Parser의 바이트 단위 탐색
+int64_t count_reference(const uint8_t *buffer, int64_t bufLen)
+{
+    int64_t count = 0;
+    for (int64_t i = 0; i + 3 <= bufLen; i++) {
+        if (buffer[i] == 0 && buffer[i + 1] == 0 && buffer[i + 2] == 1) {
+            count++;
+            i += 2;
+        }
+    }
+    return count;
+}
+
+int64_t count_start_codes(const uint8_t *buffer, int64_t bufLen)
+{
+    int64_t count = 0;
+    const uint8_t *end = buffer + bufLen;
+    const uint8_t *cur = buffer;
+    while (cur < end) {
+        const uint8_t *found = StartCodeScanner::find(cur, end - cur);
+        if (!found)
+            break;
+        count++;
+        cur = found + (found[2] == 0x01 ? 3 : 4);
+    }
+    return count;
+}
+
+void run(const char *name, const std::vector<uint8_t> &data)
+{
+    const int64_t expected = count_reference(data.data(), data.size());
+    fprintf(stdout, "%s: %.1f MB, %ld start codes\n",
+            name, data.size() / (1024.0 * 1024.0), expected);
+
+    const StartCodeScanner::Impl impls[] = {
+        StartCodeScanner::Impl::SCALAR,
+        StartCodeScanner::Impl::SSE2,
+        StartCodeScanner::Impl::AVX2,
+    };
+    for (auto impl : impls) {
+        if (!StartCodeScanner::set_impl(impl)) {
+            fprintf(stdout, "  %-7s: not supported\n", StartCodeScanner::impl_name(impl));
+            continue;
+        }
+
+        int64_t passes = 0;
+        int64_t count = 0;
+        const auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        do {
+            count = count_start_codes(data.data(), data.size());
+            passes++;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < 0.5);
+
+        fprintf(stdout, "  %-7s: %6.2f GB/s%s\n", StartCodeScanner::impl_name(impl),
+                double(data.size()) * passes / elapsed / 1e9,
+                count == expected ? "" : "  (MISMATCH)");
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const char *filename = argc > 1 ? argv[1] : "example/dragon.h264";
+    const int64_t syntheticMB = argc > 2 ? atoll(argv[2]) : 256;
+
+    auto file = read_file(filename);
+    if (file.empty()) {
+        fprintf(stderr, "failed to read %s\n", filename);
+        return EXIT_FAILURE;
+    }
+    run(filename, file);
+    run("synthetic", make_synthetic(syntheticMB * 1024 * 1024));
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+#include "yuyv_converter.hpp"
+
+// usage: yuyv_bench [seconds per case]
+namespace {
+
+struct I420Frame
+{
+    int width;
+    int height;
+    int64_t chroma_size;    // 높이가 홀수면 chroma 줄이 하나 더 있다
+    std::vector<uint8_t> data;
+
+    I420Frame(int w, int h)
+        : width(w), height(h), chroma_size(int64_t(w / 2) * ((h + 1) / 2)),
+          data(int64_t(w) * h + chroma_size * 2) {}
+
+    uint8_t *u() { return data.data() + int64_t(width) * height; }
+    uint8_t *v() { return u() + chroma_size; }
+
+    YuyvConverter::Planes planes()
+    {
+        return {data.data(), u(), v(), width, width / 2};
+    }
+};
+
+// 카메라 영상처럼 부드럽게 변하는 값에 약간의 잡음을 섞는다
+std::vector<uint8_t> make_yuyv(int width, int height)
+{
+    std::vector<uint8_t> data(width * height * 2);
+    std::mt19937 rng(20001102);
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col += 2) {
+            uint8_t *p = data.data() + (row * width + col) * 2;
+            const int noise = int(rng() % 16) - 8;
+            p[0] = uint8_t(std::min(235, std::max(16, (col + row) * 200 / (width + height) + 16 + noise)));
+            p[1] = uint8_t(128 + (col * 64 / width) - (row * 32 / height));
+            p[2] = uint8_t(std::min(235, std::max(16, p[0] + noise / 2)));
+            p[3] = uint8_t(128 - (col * 48 / width) + (row * 48 / height));
+        }
+    }
+    return data;
+}
+
+template <typename Func>
+double frames_per_second(Func func, double seconds)
+{
+    int64_t frames = 0;
+    const auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        func();
+        frames++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < seconds);
+    return frames / elapsed;
+}
+
+// 평면 하나의 최대 차이와 PSNR
+void compare_plane(const char *name, const uint8_t *a, const uint8_t *b, int64_t size)
+{
+    int maxDiff = 0;
+    double sq = 0;
+    for (int64_t i = 0; i < size; i++) {
+        const int diff = std::abs(int(a[i]) - int(b[i]));
+        maxDiff = std::max(maxDiff, diff);
+        sq += double(diff) * diff;
+    }
+    const double mse = sq / size;
+    if (mse == 0)
+        fprintf(stdout, "    %s: identical\n", name);
+    else
+        fprintf(stdout, "    %s: max diff %d, PSNR %.1f dB\n",
+                name, maxDiff, 10 * std::log10(255.0 * 255.0 / mse));
+}
+
+void run(int width, int height, double seconds)
+{
+    fprintf(stdout, "%dx%d\n", width, height);
+    const auto yuyv = make_yuyv(width, height);
+
+    I420Frame reference(width, height);
+    YuyvConverter::convert_scalar(yuyv.data(), width * 2, reference.planes(), width, height);
+
+    const YuyvConverter::Impl impls[] = {
+        YuyvConverter::Impl::SCALAR,
+        YuyvConverter::Impl::SSE2,
+        YuyvConverter::Impl::AVX2,
+        YuyvConverter::Impl::NEON,
+    };
+    I420Frame out(width, height);
+    for (auto impl : impls) {
+        if (!YuyvConverter::set_impl(impl)) {
+            fprintf(stdout, "  %-7s: not supported\n", YuyvConverter::impl_name(impl));
+            continue;
+        }
+        memset(out.data.data(), 0, out.data.size());
+        const double fps = frames_per_second([&]() {
+            YuyvConverter::convert(yuyv.data(), width * 2, out.planes(), width, height);
+        }, seconds);
+        fprintf(stdout, "  %-7s: %8.1f frames/s%s\n", YuyvConverter::impl_name(impl), fps,
+                out.data == reference.data ? "" : "  (MISMATCH)");
+    }
+
+    // 지금까지 캡처 루프가 쓰던 변환
+    SwsContext *sws = sws_getContext(width, height, AV_PIX_FMT_YUYV422,
+                                     width, height, AV_PIX_FMT_YUV420P,
+                                     SWS_BICUBIC, nullptr, nullptr, nullptr);
+    if (sws == nullptr) {
+        fprintf(stdout, "  %-7s: not available\n", "sws");
+        return;
+    }
+    uint8_t *src[4];
+    int srcStride[4];
+    uint8_t *dst[4];
+    int dstStride[4];
+    av_image_fill_arrays(src, srcStride, yuyv.data(), AV_PIX_FMT_YUYV422, width, height, 1);
+    av_image_fill_arrays(dst, dstStride, out.data.data(), AV_PIX_FMT_YUV420P, width, height, 1);
+    const double fps = frames_per_second([&]() {
+        sws_scale(sws, src, srcStride, 0, height, dst, dstStride);
+    }, seconds);
+    fprintf(stdout, "  %-7s: %8.1f frames/s (bicubic)\n", "sws", fps);
+    compare_plane("Y", out.data.data(), reference.data.data(), int64_t(width) * height);
+    compare_plane("U", out.u(), reference.u(), out.chroma_size);
+    compare_plane("V", out.v(), reference.v(), out.chroma_size);
+    sws_freeContext(sws);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const double seconds = argc > 1 ? atof(argv[1]) : 0.5;
+    run(800, 600, seconds);
+    run(1920, 1080, seconds);
+    // SIMD 폭으로 나누어떨어지지 않는 크기의 나머지 처리 확인
+    run(802, 601, seconds);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "rtsp_parser.hpp"
+#include "common.hpp"
+
+// libFuzzer 입력: 첫 바이트로 recv 한 번의 크기를 정하고 나머지를 그만큼씩 잘라
+// read_client처럼 RTSP_RECV_BUF_SIZE 버퍼에 이어 붙이며 해석한다
+namespace {
+
+void check_view(const StrView &view, const char *begin, const char *end)
+{
+    if (view.size < 0 || (view.size && (view.data < begin || view.data + view.size > end)))
+        abort();
+}
+
+// 숫자 헤더는 앞의 숫자를 잘라 읽지 않고 전부 읽었어야 한다
+void check_number(const StrView &value, const int64_t parsed)
+{
+    int64_t pos = (value.size && (value.data[0] == '-' || value.data[0] == '+')) ? 1 : 0;
+    const bool negative = pos && value.data[0] == '-';
+    int64_t expected = 0;
+    int64_t digits = 0;
+    for (; pos < value.size && value.data[pos] >= '0' && value.data[pos] <= '9'; pos++, digits++) {
+        if (digits < 18)
+            expected = expected * 10 + (value.data[pos] - '0');
+    }
+    if (digits == 0 || digits > 9 || (negative ? -expected : expected) != parsed)
+        abort();
+}
+
+// npt는 숫자로 시작해야 하고, on_seek이 frame 번호로 바꿔도 넘치지 않는 유한한 값이어야 한다
+void check_npt(const StrView &value)
+{
+    double npt = -1;
+    if (!value.to_double(npt))
+        return;
+    if (!value.size || value.data[0] < '0' || value.data[0] > '9' ||
+        !std::isfinite(npt) || npt < 0 || npt >= 1e9)
+        abort();
+}
+
+void check_request(const RtspRequest &request, const char *begin, const char *end)
+{
+    check_view(request.raw, begin, end);
+    check_view(request.method, begin, end);
+    check_view(request.url, begin, end);
+    check_view(request.version, begin, end);
+    check_view(request.body, begin, end);
+    if (request.header_count < 0 || request.header_count > RtspRequest::MAX_HEADERS)
+        abort();
+    for (int i = 0; i < request.header_count; i++) {
+        check_view(request.headers[i].name, begin, end);
+        check_view(request.headers[i].value, begin, end);
+    }
+    // 같은 헤더가 여러 번 오면 마지막 값을 쓴다
+    for (int i = request.header_count - 1; i >= 0; i--) {
+        if (request.headers[i].name.iequals("CSeq")) {
+            check_number(request.headers[i].value, request.cseq);
+            break;
+        }
+    }
+    for (int i = request.header_count - 1; i >= 0; i--) {
+        if (request.headers[i].name.iequals("Content-Length")) {
+            check_number(request.headers[i].value, request.body.size);
+            break;
+        }
+    }
+
+    int64_t first = 0;
+    int64_t second = 0;
+    const StrView transport = request.get_header("Transport");
+    RtspParser::get_param_pair(transport, "client_port", first, second);
+    RtspParser::get_param_pair(transport, "interleaved", first, second);
+    const StrView range = request.get_header("Range");
+    const int64_t nptPos = range.find("npt=");
+    if (nptPos >= 0)
+        check_npt(range.substr(nptPos + 4));
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 1)
+        return 0;
+    const int64_t chunk = 1 + data[0] % 64;
+    data++;
+    size--;
+
+    // 버퍼 바로 뒤를 읽으면 ASan이 잡도록 정확한 크기로 잡는다
+    std::vector<char> recvBuf(RTSP_RECV_BUF_SIZE);
+    int64_t recvLen = 0;
+    RtspParser parser;
+    RtspRequest request;
+    for (size_t offset = 0; offset < size; offset += chunk) {
+        const int64_t len = std::min<int64_t>(chunk, size - offset);
+        if (recvLen + len > int64_t(recvBuf.size()))
+            return 0;   // read_client는 여기서 연결을 닫는다
+        memcpy(recvBuf.data() + recvLen, data + offset, len);
+        recvLen += len;
+
+        int64_t pos = 0;
+        while (pos < recvLen) {
+            int64_t consumed = 0;
+            const auto result = parser.parse(recvBuf.data() + pos, recvLen - pos, request, consumed);
+            if (result == RtspParser::Result::INCOMPLETE)
+                break;
+            if (result == RtspParser::Result::ERROR)
+                return 0;
+            if (consumed <= 0 || consumed > recvLen - pos)
+                abort();
+            check_request(request, recvBuf.data() + pos, recvBuf.data() + pos + consumed);
+            pos += consumed;
+        }
+        memmove(recvBuf.data(), recvBuf.data() + pos, recvLen - pos);
+        recvLen -= pos;
+    }
+    return 0;
+}
+
+#ifdef RTSP_FUZZ_STANDALONE
+// libFuzzer 없이 코퍼스 파일들을 한 번씩 돌려 본다
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        FILE *f = fopen(argv[i], "rb");
+        if (!f) {
+            fprintf(stderr, "failed to open %s\n", argv[i]);
+            continue;
+        }
+        std::vector<uint8_t> input;
+        uint8_t buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+            input.insert(input.end(), buffer, buffer + n);
+        fclose(f);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    return 0;
+}
+#endif
\ No newline at end of file
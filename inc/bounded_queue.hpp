@@ -0,0 +1,85 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 파이프라인 단계 사이의 고정 크기 큐. 넣는 쪽은 기다리지 않고(가득 차면 실패),
+// 꺼내는 쪽은 항목이 들어오거나 close()될 때까지 기다릴 수 있다
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(int64_t capacity) : items(capacity < 1 ? 1 : capacity) {}
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    bool try_push(T item)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->closed || this->count == int64_t(this->items.size()))
+                return false;
+            this->items[(this->head + this->count) % this->items.size()] = std::move(item);
+            this->count++;
+        }
+        this->not_empty.notify_one();
+        return true;
+    }
+
+    // depth는 꺼내기 전에 큐에 있던 항목 수
+    bool try_pop(T &item, int64_t *depth = nullptr)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->pop_locked(item, depth);
+    }
+
+    // 항목이 없으면 기다린다. close()된 뒤 비어 있으면 false
+    bool pop(T &item, int64_t *depth = nullptr)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->not_empty.wait(lock, [this]() { return this->count > 0 || this->closed; });
+        return this->pop_locked(item, depth);
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->closed = true;
+        }
+        this->not_empty.notify_all();
+    }
+
+    int64_t capacity() const
+    {
+        return this->items.size();
+    }
+
+private:
+    std::vector<T> items;
+    int64_t head = 0;
+    int64_t count = 0;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+
+    bool pop_locked(T &item, int64_t *depth)
+    {
+        if (this->count == 0)
+            return false;
+        if (depth)
+            *depth = this->count;
+        item = std::move(this->items[this->head]);
+        this->items[this->head] = T();
+        this->head = (this->head + 1) % this->items.size();
+        this->count--;
+        return true;
+    }
+};
+
+#endif //BOUNDED_QUEUE_HPP
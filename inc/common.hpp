@@ -7,30 +7,93 @@
 #define HEIGHT 600
 #define FRAME_COUNT 30
 #define VIDEODEV "/dev/video0"
-#define OUTPUT_FILENAME "output.h264"
+#define RECORD_PREFIX "output"   // output_00000.h264, output_00000.idx, ...
 
 constexpr int64_t IP_V4_HEADER_SIZE = 20;
 constexpr int64_t UDP_HEADER_SIZE = 8;
 constexpr int64_t RTP_HEADER_SIZE = 12;
 constexpr int64_t RTP_VERSION = 2;
 constexpr int64_t RTP_PAYLOAD_TYPE_H264 = 96;
+constexpr int64_t RTP_PAYLOAD_TYPE_RTX = 97;   // RFC 4588 재전송, apt=96
+constexpr uint32_t RTP_H264_CLOCK_RATE = 90000;
 constexpr int64_t FU_SIZE = 2;
+constexpr int64_t STAP_A_HEADER_SIZE = 1;
+constexpr int64_t STAP_A_NALU_SIZE_LEN = 2;
 
 constexpr uint16_t SERVER_RTP_PORT = 12345;
 constexpr uint16_t SERVER_RTCP_PORT = SERVER_RTP_PORT + 1;
 constexpr uint16_t SERVER_RTSP_PORT = 8554;
 
+// SETUP에서 Transport: RTP/AVP;multicast를 요청한 세션이 같이 받는 그룹
+constexpr const char *MULTICAST_DEFAULT_GROUP = "239.255.12.42";
+constexpr uint16_t MULTICAST_DEFAULT_PORT = 5004;
+constexpr int MULTICAST_DEFAULT_TTL = 1;    // 같은 LAN 안에서만
+
+constexpr int64_t RTSP_RECV_BUF_SIZE = 4096;
+constexpr int64_t RTSP_SEND_BUF_SIZE = 2048;
+constexpr int64_t RTSP_LISTEN_QUEUE = 128;
+// interleaved 전송에서 소켓에 못 쓰고 쌓아 둘 수 있는 최대 크기. 넘으면 참조 프레임도 버린다
+constexpr int64_t RTSP_TCP_MAX_BACKLOG = 512 * 1024;
+// 세션 timeout 동안 요청이나 RTCP가 없으면 끊는다. 이 간격으로 timer wheel을 돌린다
+constexpr int64_t RTSP_SESSION_TICK_MS = 1000;
+constexpr int64_t RTSP_SESSION_WHEEL_SLOTS = 64;
+
 constexpr int64_t MAX_UDP_PACKET_SIZE = 65535;
 constexpr int64_t MAX_RTP_DATA_SIZE = MAX_UDP_PACKET_SIZE - IP_V4_HEADER_SIZE
                                       - UDP_HEADER_SIZE - RTP_HEADER_SIZE - FU_SIZE;
 constexpr int64_t MAX_RTP_PACKET_LEN = MAX_RTP_DATA_SIZE + RTP_HEADER_SIZE + FU_SIZE;
 
-//constexpr uint8_t NALU_F_MASK = 0x80;
+constexpr int64_t DEFAULT_PATH_MTU = 1400;
+constexpr int64_t MIN_PATH_MTU = 576;
+
+constexpr int64_t PACER_REPORT_SECONDS = 10;
+// 자동 pacing: 한 프레임을 조각마다 이만큼의 패킷으로 나누되 PACE_MAX_SLICES를 넘지 않는다
+constexpr int64_t PACE_PACKETS_PER_SLICE = 4;
+constexpr int64_t PACE_MAX_SLICES = 8;
+
+constexpr int64_t RTCP_SR_INTERVAL_MS = 1000;
+constexpr int64_t RTCP_MAX_PACKET_SIZE = 1500;
+constexpr const char *RTCP_CNAME = "rtspMediaStream";
+// NACK 재전송을 위해 UDP 세션마다 최근 패킷을 복사해 둘 메모리
+constexpr int64_t RTX_CACHE_BUDGET = 1024 * 1024;
+
+// 카메라 인코더 목표 bitrate 범위 (bps)
+constexpr int64_t CAM_MIN_BIT_RATE = 150000;
+constexpr int64_t CAM_START_BIT_RATE = 400000;
+constexpr int64_t CAM_MAX_BIT_RATE = 2000000;
+constexpr int64_t RATE_CONTROL_INTERVAL_MS = 1000;
+// 캡처 스레드와 인코더 사이에 쌓아 둘 최대 프레임 수. 넘으면 가장 오래된 프레임을 덮어쓴다
+constexpr int64_t CAM_FRAME_RING_DEPTH = 4;
+// 인코더 출력을 송신/녹화 단계로 넘기는 큐 크기 (패킷 수). 가득 차면 다음 IDR까지 버린다
+constexpr int64_t CAM_SEND_QUEUE_DEPTH = 8;
+// 녹화 큐는 SD 카드 쓰기가 몇 초 멈춰도 버티도록 크게 잡는다
+constexpr int64_t CAM_RECORD_QUEUE_DEPTH = 90;
+// 녹화 세그먼트는 이 시간이나 크기를 넘긴 뒤 다음 IDR에서 나눈다
+constexpr int64_t CAM_RECORD_SEGMENT_SECONDS = 60;
+constexpr int64_t CAM_RECORD_SEGMENT_BYTES = 64 * 1024 * 1024;
+constexpr int64_t CAM_RECORD_WRITE_BUFFER = 1024 * 1024;
+constexpr bool CAM_RECORD_DIRECT_IO = false;   // O_DIRECT로 page cache를 거치지 않고 쓴다
+// 중간에 들어온 시청자에게 보낼 마지막 GOP의 최대 크기. 넘으면 다음 IDR까지 캐시하지 않는다
+constexpr int64_t CAM_GOP_CACHE_MAX_BYTES = 4 * 1024 * 1024;
+// 캐시한 GOP를 실시간의 몇 배 속도로 보낼지
+constexpr int64_t CAM_GOP_BURST_SPEED = 4;
+// 파이프라인 단계마다 이만큼 처리할 때마다 통계를 출력한다
+constexpr int64_t STAGE_REPORT_ITEMS = 300;
+
+constexpr uint8_t NALU_F_MASK = 0x80;
 constexpr uint8_t NALU_NRI_MASK = 0x60;
 constexpr uint8_t NALU_F_NRI_MASK = 0xe0;
 constexpr uint8_t NALU_TYPE_MASK = 0x1F;
 constexpr uint8_t FU_S_MASK = 0x80;
 constexpr uint8_t FU_E_MASK = 0x40;
 constexpr uint8_t SET_FU_A_MASK = 0x1C;
+constexpr uint8_t SET_STAP_A_MASK = 0x18;
+
+constexpr uint8_t NALU_TYPE_SLICE = 1;
+constexpr uint8_t NALU_TYPE_IDR = 5;
+constexpr uint8_t NALU_TYPE_SEI = 6;
+constexpr uint8_t NALU_TYPE_SPS = 7;
+constexpr uint8_t NALU_TYPE_PPS = 8;
+constexpr uint8_t NALU_TYPE_AUD = 9;
 
 #endif //COMMON_HPP
\ No newline at end of file
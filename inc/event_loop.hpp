@@ -0,0 +1,53 @@
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+class EventLoop
+{
+public:
+    using Handler = std::function<void(uint32_t events)>;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    bool add(int fd, uint32_t events, Handler handler);
+    bool modify(int fd, uint32_t events);
+    void remove(int fd);
+
+    int add_timer(int64_t intervalNs, std::function<void()> handler);
+    // CLOCK_MONOTONIC 절대 시각에 한 번 깨운다. 핸들러가 다음 시각을 돌려주면 다시 걸고, 0 이하면 멈춘다
+    int add_deadline_timer(std::function<int64_t()> handler);
+    bool set_deadline(int timerfd, int64_t deadlineNs);
+    void remove_timer(int timerfd);
+
+    static int64_t now_ns();
+
+    void run();
+    void stop();
+
+private:
+    // 같은 fd가 닫히고 다시 등록되면 generation이 바뀐다. epoll_event.data에 fd와 같이 넣어
+    // 한 번의 epoll_wait 결과 안에서 예전 등록으로 온 이벤트를 새 핸들러로 넘기지 않는다
+    struct Registration
+    {
+        uint32_t generation;
+        std::shared_ptr<Handler> handler;
+    };
+
+    int epoll_fd = -1;
+    bool running = false;
+    uint32_t next_generation = 0;
+    std::unordered_map<int, Registration> handlers;
+
+    static uint64_t pack_data(int fd, uint32_t generation);
+};
+
+#endif //EVENT_LOOP_HPP
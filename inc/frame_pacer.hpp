@@ -0,0 +1,77 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+struct PacerStats
+{
+    int64_t frames = 0;
+    int64_t late_frames = 0;    // 한 프레임 주기 이상 늦게 깨어난 횟수
+    int64_t resyncs = 0;        // 너무 늦어서 시계를 다시 맞춘 횟수
+    double lateness_sum = 0;    // us
+    double lateness_sq_sum = 0;
+    double lateness_max = 0;
+    double drift = 0;           // 마지막 tick의 예정 시각 대비 어긋난 정도 (us)
+
+    double mean_lateness() const;
+    double jitter() const;
+    void print(const char *name) const;
+};
+
+// 프레임 n의 송신 시각을 start + n * interval 로 정해 두고 그 시각에 맞춰 깨운다.
+// 보내는 데 걸린 시간이 다음 deadline에 누적되지 않는다
+class FramePacer
+{
+public:
+    explicit FramePacer(double fps = 30);
+
+    void set_fps(double fps);
+    int64_t get_interval() const;
+
+    void start(int64_t nowNs);
+    // 지금 보낼 프레임의 예정 시각, 다음 프레임의 예정 시각
+    int64_t get_frame_start() const;
+    int64_t get_deadline() const;
+
+    // deadline에 깨어났을 때 부른다. 늦은 정도를 기록하고 다음 프레임으로 넘어간다
+    void tick(int64_t nowNs);
+
+    const PacerStats &get_stats() const;
+
+private:
+    double fps = 30;
+    int64_t start_ns = 0;
+    int64_t frame = 0;
+    PacerStats stats;
+
+    int64_t deadline_of(int64_t frame) const;
+};
+
+inline int64_t FramePacer::get_interval() const
+{
+    return int64_t(1000000000 / this->fps);
+}
+
+inline int64_t FramePacer::get_frame_start() const
+{
+    return this->deadline_of(this->frame - 1);
+}
+
+inline int64_t FramePacer::get_deadline() const
+{
+    return this->deadline_of(this->frame);
+}
+
+inline const PacerStats &FramePacer::get_stats() const
+{
+    return this->stats;
+}
+
+inline int64_t FramePacer::deadline_of(const int64_t frame) const
+{
+    // fps가 정수가 아니어도 오차가 쌓이지 않도록 매번 처음부터 계산한다
+    return this->start_ns + int64_t(frame * 1e9 / this->fps);
+}
+
+#endif //FRAME_PACER_HPP
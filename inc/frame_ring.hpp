@@ -0,0 +1,97 @@
+#ifndef FRAME_RING_HPP
+#define FRAME_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct FrameRingStats
+{
+    int64_t published = 0;
+    int64_t consumed = 0;
+    int64_t overwritten = 0;    // 읽기 전에 새 프레임이 덮어쓴 프레임
+    int64_t skipped = 0;        // 더 새 프레임을 먼저 읽어서 버린 프레임
+
+    void print(const char *name) const;
+};
+
+// 캡처 스레드 하나가 쓰고 인코딩 스레드 하나만 읽는 lock-free 프레임 ring.
+// 슬롯은 미리 잡아 두고 제자리에 쓴 뒤 인덱스만 넘긴다. 가득 차면 가장 오래된 프레임을 덮어쓴다.
+//
+// 슬롯은 depth + 2개이고 항상 주인이 하나다: 쓰는 쪽의 여분, 읽는 쪽의 여분, ring의 칸.
+// 쓰는 쪽은 다 쓴 슬롯을 칸과 exchange해서 나온 슬롯을 다음 여분으로 쓰고,
+// 읽는 쪽도 자기 여분을 칸과 exchange해서 프레임을 꺼내므로 읽는 중인 슬롯은 덮어쓰이지 않는다
+class FrameRing
+{
+public:
+    FrameRing(int64_t depth, int64_t frameSize);
+
+    FrameRing(const FrameRing &) = delete;
+    FrameRing &operator=(const FrameRing &) = delete;
+
+    // 쓰는 쪽: 다음 프레임을 쓸 버퍼. publish() 전까지 같은 버퍼다
+    uint8_t *get_write_buffer();
+    // timestampNs는 acquire()에서 그대로 돌려준다 (캡처 시각 등)
+    void publish(int64_t timestampNs = 0);
+
+    // 읽는 쪽: 아직 읽지 않은 가장 오래된 프레임. 없으면 nullptr.
+    // 돌려준 버퍼는 다음 acquire() 호출 전까지 유효하다
+    const uint8_t *acquire(int64_t *timestampNs = nullptr);
+    // 읽는 쪽: 아직 읽지 않고 쌓인 프레임 수
+    int64_t get_pending() const;
+
+    int64_t get_frame_size() const;
+    FrameRingStats get_stats() const;
+
+private:
+    static constexpr uint32_t FRESH = 0x80000000u;  // 칸에 아직 읽지 않은 프레임이 있다
+    static constexpr int64_t CACHE_LINE_SIZE = 64;
+
+    int64_t depth;
+    int64_t frame_size;
+    int64_t slot_stride;
+    std::vector<uint8_t> storage;
+    uint8_t *slots_base = nullptr;
+    std::vector<uint64_t> slot_seqs;                // 슬롯에 담긴 프레임 번호
+    std::vector<int64_t> slot_times;
+    std::unique_ptr<std::atomic<uint32_t>[]> cells; // 슬롯 인덱스 | FRESH
+
+    // 쓰는 쪽만 바꾼다
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail{0};
+    uint32_t write_slot = 0;
+    std::atomic<int64_t> overwritten{0};
+
+    // 읽는 쪽만 바꾼다
+    alignas(CACHE_LINE_SIZE) uint64_t head = 0;
+    uint32_t read_slot = 1;
+    std::atomic<int64_t> consumed{0};
+    std::atomic<int64_t> skipped{0};
+
+    uint8_t *slot_data(uint32_t slot);
+};
+
+inline int64_t FrameRing::get_frame_size() const
+{
+    return this->frame_size;
+}
+
+inline uint8_t *FrameRing::slot_data(const uint32_t slot)
+{
+    return this->slots_base + slot * this->slot_stride;
+}
+
+inline int64_t FrameRing::get_pending() const
+{
+    const uint64_t tail = this->tail.load(std::memory_order_acquire);
+    const uint64_t pending = tail > this->head ? tail - this->head : 0;
+    return pending < uint64_t(this->depth) ? int64_t(pending) : this->depth;
+}
+
+inline uint8_t *FrameRing::get_write_buffer()
+{
+    return this->slot_data(this->write_slot);
+}
+
+#endif //FRAME_RING_HPP
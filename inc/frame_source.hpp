@@ -0,0 +1,103 @@
+#ifndef FRAME_SOURCE_HPP
+#define FRAME_SOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class PixelFormat
+{
+    YUYV,       // packed 4:2:2, 한 줄 width * 2 바이트
+    I420,       // planar 4:2:0, Y, U, V 순서로 붙어 있다
+};
+
+// 카메라 파이프라인에 넣을 프레임을 만드는 곳
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    virtual bool open(int width, int height) = 0;
+    // 다음 프레임. 다음 read() 전까지 유효하다. 끝났거나 실패하면 nullptr
+    virtual const uint8_t *read() = 0;
+    virtual PixelFormat get_format() const = 0;
+    // 장치가 스스로 frame rate를 맞추면 true. 아니면 읽는 쪽이 간격을 맞춰야 한다
+    virtual bool is_live() const;
+    virtual const char *get_name() const = 0;
+
+    // "v4l2[:장치]", "synthetic", "file:경로(.y4m이면 Y4M, 아니면 raw YUYV)"
+    static std::unique_ptr<FrameSource> create(const std::string &spec);
+};
+
+// 프레임마다 조금씩 움직이는 그라데이션과 상자. 같은 프레임 번호면 항상 같은 그림이다
+class SyntheticSource : public FrameSource
+{
+public:
+    bool open(int width, int height) override;
+    const uint8_t *read() override;
+    PixelFormat get_format() const override;
+    const char *get_name() const override;
+
+private:
+    int width = 0;
+    int height = 0;
+    int64_t frame = 0;
+    std::vector<uint8_t> buffer;
+};
+
+// Y4M(4:2:0) 또는 raw YUYV 파일. 끝까지 읽으면 처음으로 돌아간다
+class FileSource : public FrameSource
+{
+public:
+    explicit FileSource(const std::string &path);
+    ~FileSource() override;
+
+    bool open(int width, int height) override;
+    const uint8_t *read() override;
+    PixelFormat get_format() const override;
+    const char *get_name() const override;
+
+private:
+    std::string path;
+    FILE *file = nullptr;
+    bool y4m = false;
+    long data_start = 0;        // 첫 프레임 위치
+    std::vector<uint8_t> buffer;
+
+    bool parse_y4m_header(int width, int height);
+    bool read_frame();
+};
+
+// V4L2 mmap 캡처 (YUYV)
+class V4L2Source : public FrameSource
+{
+public:
+    explicit V4L2Source(const std::string &device);
+    ~V4L2Source() override;
+
+    bool open(int width, int height) override;
+    const uint8_t *read() override;
+    PixelFormat get_format() const override;
+    bool is_live() const override;
+    const char *get_name() const override;
+
+private:
+    struct Buffer
+    {
+        void *start;
+        size_t length;
+    };
+
+    std::string device;
+    int fd{-1};
+    std::vector<Buffer> buffers;
+    int queued_index{-1};       // 지난 read()가 돌려준 버퍼. 다음 read()에서 다시 넣는다
+
+    void init_device(int width, int height);
+    void init_mmap();
+};
+
+#endif //FRAME_SOURCE_HPP
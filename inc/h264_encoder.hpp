@@ -0,0 +1,60 @@
+#ifndef H264_ENCODER_HPP
+#define H264_ENCODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+
+// 인코더 출력 한 개. 모든 세션이 같은 버퍼를 참조 카운트로 공유한다
+struct EncodedPacket {
+    std::vector<uint8_t> data;
+    int64_t pts = 0;
+    bool keyframe = false;
+};
+
+using EncodedPacketPtr = std::shared_ptr<const EncodedPacket>;
+
+class H264Encoder
+{
+public:
+    H264Encoder() = default;
+    ~H264Encoder();
+
+    H264Encoder(const H264Encoder &) = delete;
+    H264Encoder &operator=(const H264Encoder &) = delete;
+
+    bool open(int width, int height, int fps, int64_t bitRate);
+    void close();
+    bool is_open() const;
+
+    void request_keyframe();
+    // 열린 채로 목표 bitrate를 바꾼다. libx264는 다음 프레임부터 다시 설정한다
+    void set_bitrate(int64_t bitRate);
+    int64_t get_bitrate() const;
+    bool encode(const uint8_t *const planes[3], const int strides[3],
+                std::vector<EncodedPacketPtr> &packets);
+
+private:
+    AVCodecContext *c = nullptr;
+    AVFrame *frame = nullptr;
+    AVPacket *pkt = nullptr;
+    int64_t pts = 1;
+    bool force_keyframe = false;
+};
+
+inline bool H264Encoder::is_open() const
+{
+    return this->c != nullptr;
+}
+
+inline void H264Encoder::request_keyframe()
+{
+    this->force_keyframe = true;
+}
+
+#endif //H264_ENCODER_HPP
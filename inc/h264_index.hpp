@@ -0,0 +1,64 @@
+#ifndef H264_INDEX_HPP
+#define H264_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma pack(1)
+
+struct NalEntry
+{
+    int64_t offset;        // start code를 포함한 NAL 시작 위치
+    int64_t size;          // start code를 포함한 크기
+    int32_t frame;         // 이 NAL이 속한 access unit 번호
+    uint8_t type;
+    uint8_t startCodeLen;
+};
+
+#pragma pack()
+
+// H.264 파일의 NAL 위치, 타입, IDR 위치를 한 번만 스캔해서 기억한다
+class H264Index
+{
+public:
+    bool build(const uint8_t *data, int64_t dataSize);
+    bool load(const std::string &path, int64_t fileSize, int64_t fileMtime);
+    bool save(const std::string &path, int64_t fileSize, int64_t fileMtime) const;
+
+    int64_t get_nal_count() const;
+    const NalEntry &get_nal(int64_t nalIndex) const;
+    int64_t get_frame_count() const;
+    int64_t get_frame_start(int64_t frame) const;
+    int64_t find_idr_frame(int64_t frame) const;
+
+private:
+    std::vector<NalEntry> nals;
+    std::vector<int64_t> frame_starts;   // frame -> 첫 NAL 인덱스
+    std::vector<int64_t> idr_frames;     // IDR slice를 가진 frame 번호 (오름차순)
+
+    void build_frame_table();
+};
+
+inline int64_t H264Index::get_nal_count() const
+{
+    return this->nals.size();
+}
+
+inline const NalEntry &H264Index::get_nal(const int64_t nalIndex) const
+{
+    return this->nals[nalIndex];
+}
+
+inline int64_t H264Index::get_frame_count() const
+{
+    return this->frame_starts.size();
+}
+
+inline int64_t H264Index::get_frame_start(const int64_t frame) const
+{
+    return this->frame_starts[frame];
+}
+
+#endif //H264_INDEX_HPP
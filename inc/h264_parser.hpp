@@ -4,19 +4,42 @@
 #include <utility>
 #include <cstddef>
 #include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
 #include <sys/types.h>
 
+#include "h264_index.hpp"
+
+// start code를 뺀 NAL 하나
+struct NalUnit
+{
+    const uint8_t *data;
+    int64_t size;
+};
+
 class H264Parser
 {
 public:
-    explicit H264Parser(const char *filename);
+    // cacheIndex면 <filename>.idx 사이드카에서 인덱스를 읽고, 없거나 낡았으면 새로 만들어 저장한다
+    explicit H264Parser(const char *filename, bool cacheIndex = false);
     ~H264Parser();
 
     static bool is_start_code(const uint8_t *_buffer,
                               int64_t _bufLen, 
                               uint8_t start_code_type);
+    // Annex B 버퍼(access unit 하나)를 NAL 단위로 나눈다
+    static void split_nal_units(const uint8_t *data, int64_t dataSize,
+                                std::vector<NalUnit> &nals);
                               
     std::pair<const uint8_t *, int64_t> get_next_frame();
+    std::pair<const uint8_t *, int64_t> get_next_frame(int64_t &offset) const;
+
+    const H264Index &get_index() const;
+    // 인덱스의 nalIndex번째 NAL (start code 포함)
+    std::pair<const uint8_t *, int64_t> get_nal(int64_t nalIndex) const;
+    // frame번째 access unit의 NAL들을 start code째로 묶은 구간
+    std::pair<const uint8_t *, int64_t> get_frame(int64_t frame) const;
 
 private:
     int fd = -1;
@@ -26,6 +49,14 @@ private:
     uint8_t *ptr_mapped_file_start = nullptr;
     uint8_t *ptr_mapped_file_end = nullptr;
     int64_t file_size = 0;
+    H264Index index;
+
+    void load_index(const std::string &filename, const struct stat &file_stat, bool cacheIndex);
 };
 
+inline const H264Index &H264Parser::get_index() const
+{
+    return this->index;
+}
+
 #endif //H264_PARSER_HPP
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef RATE_CONTROLLER_HPP
+#define RATE_CONTROLLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// 한 주기 동안 모은 시청자 쪽 상태. 여러 시청자가 있으면 가장 나쁜 값을 넣는다
+struct RateSample
+{
+    bool has_report = false;        // 이번 주기에 RTCP RR을 받았을 때만 손실/지터를 본다
+    double fraction_lost = 0;       // RTCP RR, 0 ~ 1
+    double jitter_ms = 0;
+    int64_t queue_bytes = 0;        // 소켓에 못 쓰고 쌓인 양
+    int64_t dropped_frames = 0;     // 직전 샘플 이후 혼잡으로 버린 프레임
+};
+
+// 손실/지터/송신 큐를 보고 인코더 목표 bitrate를 AIMD로 조절한다.
+// 나쁠 때는 바로 줄이고, 좋은 샘플이 여러 번 이어져야 조금씩 올린다. 그 사이는 유지한다
+class RateController
+{
+public:
+    RateController(int64_t minBitRate, int64_t maxBitRate, int64_t startBitRate);
+
+    // 목표 bitrate나 frame 간격이 바뀌었으면 true
+    bool update(const RateSample &sample, int64_t nowNs);
+
+    int64_t get_bitrate() const;
+    // n이면 캡처한 n 프레임 중 하나만 인코딩한다 (bitrate가 최소인데도 혼잡할 때)
+    int get_frame_divisor() const;
+
+private:
+    int64_t min_bitrate;
+    int64_t max_bitrate;
+    int64_t bitrate;
+    int frame_divisor = 1;
+    int good_samples = 0;
+    int64_t last_decrease = 0;
+};
+
+inline int64_t RateController::get_bitrate() const
+{
+    return this->bitrate;
+}
+
+inline int RateController::get_frame_divisor() const
+{
+    return this->frame_divisor;
+}
+
+#endif //RATE_CONTROLLER_HPP
@@ -14,15 +14,43 @@ public:
                                    const int ssrcNum, const char *sessionID,
                                    const int timeout);
 
+    static void replyCmd_SETUP_INTERLEAVED(char *buffer,      const int64_t bufferLen,
+                                           const int cseq,    const int rtpChannel,
+                                           const int ssrcNum, const char *sessionID,
+                                           const int timeout);
+
+    static void replyCmd_SETUP_MULTICAST(char *buffer,      const int64_t bufferLen,
+                                         const int cseq,    const char *group,
+                                         const int port,    const int ttl,
+                                         const int ssrcNum, const char *sessionID,
+                                         const int timeout);
+
     static void replyCmd_PLAY     (char *buffer,      const int64_t bufferLen,
                                    const int cseq,    const char *sessionID,
-                                   const int timeout);
+                                   const int timeout, const double rangeStart = 0);
 
     static void replyCmd_HEARTBEAT(char *buffer,      const int64_t bufferLen,
                                    const int cseq,    const char *sessionID);
                                    
     static void replyCmd_DESCRIBE (char *buffer,      const int64_t bufferLen,
-                                   const int cseq,    const char *url);
+                                   const int cseq,    const char *url,
+                                   const char *sdpMedia);
+
+    // DESCRIBE의 SDP 중 o= 다음 부분. sps/pps(start code 제외)가 있으면
+    // sprop-parameter-sets와 profile-level-id를 넣는다. 실패하면 -1
+    static int64_t build_SDP_media(char *buffer,      const int64_t bufferLen,
+                                   const uint8_t *sps, const int64_t spsLen,
+                                   const uint8_t *pps, const int64_t ppsLen);
+
+    static void replyCmd_GET_PARAMETER(char *buffer,  const int64_t bufferLen,
+                                       const int cseq, const char *sessionID);
+
+    static void replyCmd_TEARDOWN (char *buffer,      const int64_t bufferLen,
+                                   const int cseq,    const char *sessionID);
+
+    static void replyCmd_ERROR    (char *buffer,      const int64_t bufferLen,
+                                   const int cseq,    const int statusCode,
+                                   const char *reason);
 };
 
 #endif //REQUEST_HANDLER_HPP
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef RTCP_HPP
+#define RTCP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr uint8_t RTCP_PT_SR = 200;
+constexpr uint8_t RTCP_PT_RR = 201;
+constexpr uint8_t RTCP_PT_SDES = 202;
+constexpr uint8_t RTCP_PT_BYE = 203;
+constexpr uint8_t RTCP_PT_RTPFB = 205;     // transport layer feedback (RFC 4585)
+constexpr uint8_t RTCP_FMT_NACK = 1;       // generic NACK
+
+// RR/SR의 report block 하나 (RFC 3550 6.4.1)
+struct RtcpReportBlock
+{
+    uint32_t ssrc;
+    uint8_t fractionLost;
+    int32_t cumulativeLost;
+    uint32_t highestSeq;
+    uint32_t jitter;
+    uint32_t lsr;
+    uint32_t dlsr;
+};
+
+// 수신자가 알려 온 네트워크 상태
+struct RtcpStats
+{
+    int64_t reports = 0;
+    double fraction_lost = 0;       // 0 ~ 1
+    int64_t cumulative_lost = 0;
+    uint32_t highest_seq = 0;
+    double jitter_ms = 0;
+    double rtt_ms = -1;             // 아직 모르면 음수
+
+    void print(const char *name) const;
+};
+
+class Rtcp
+{
+public:
+    // 64비트 NTP 시각 (상위 32비트 초, 하위 32비트 소수)
+    static uint64_t ntp_now();
+
+    // SR + SDES(CNAME) compound 패킷을 만든다. 만든 길이를 돌려주고 버퍼가 작으면 -1
+    static int64_t build_sender_report(uint8_t *buffer, int64_t bufferLen,
+                                       uint32_t ssrc, uint64_t ntp, uint32_t rtpTimestamp,
+                                       uint32_t packetCount, uint32_t octetCount,
+                                       const char *cname);
+
+    // compound 패킷의 SR/RR에서 report block을 모두 꺼낸다. 형식이 틀리면 false
+    static bool parse_report_blocks(const uint8_t *data, int64_t dataLen,
+                                    std::vector<RtcpReportBlock> &blocks);
+
+    // compound 패킷의 generic NACK 중 mediaSsrc에 대한 것을 잃어버린 seq 목록으로 풀어 준다.
+    // 받은 NACK 메시지 수를 돌려주고 형식이 틀리면 -1
+    static int64_t parse_nacks(const uint8_t *data, int64_t dataLen, uint32_t mediaSsrc,
+                               std::vector<uint16_t> &seqs);
+
+    static void update_stats(RtcpStats &stats, const RtcpReportBlock &block,
+                             uint64_t arrivalNtp, uint32_t clockRate);
+};
+
+#endif //RTCP_HPP
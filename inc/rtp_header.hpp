@@ -24,10 +24,12 @@ public:
     void set_timestamp(const uint32_t _newtimestamp);
     void set_ssrc(const uint32_t SSRC);
     void set_seq(const uint32_t _seq);
+    void set_marker(const uint8_t _marker);
 
     void *get_header() const;
     uint32_t get_timestamp() const;
     uint32_t get_seq() const;
+    uint8_t get_marker() const;
     
 private:
     //byte 0
@@ -56,6 +58,11 @@ inline void RtpHeader::set_seq(const uint32_t _seq)
     this->seq = htons(_seq);
 }
 
+inline void RtpHeader::set_marker(const uint8_t _marker)
+{
+    this->marker = _marker ? 1 : 0;
+}
+
 inline void RtpHeader::set_ssrc(const uint32_t SSRC)
 {
     this->ssrc = htonl(SSRC);
@@ -76,6 +83,11 @@ inline uint32_t RtpHeader::get_seq() const
     return ntohs(this->seq);
 }
 
+inline uint8_t RtpHeader::get_marker() const
+{
+    return this->marker;
+}
+
 #pragma pack()
 
 #endif //RTP_HEADER_HPP
@@ -21,11 +21,15 @@ public:
     
     int64_t rtp_sendto(int sockfd,         int64_t _bufferLen, int flags,
                        const sockaddr *to, uint32_t timeStampStep);
+    void advance(uint32_t timeStampStep);
+    void next_seq();
 
     void set_header_seq(const uint32_t _seq);
     void set_header_timestamp(const uint32_t _newtimestamp);
+    void set_header_marker(const bool _marker);
 
     uint8_t *get_payload();
+    const uint8_t *get_packet() const;
     uint32_t get_header_seq();
     uint32_t get_header_timestamp();
 
@@ -36,11 +40,33 @@ private:
     uint16_t cached_cur_seq = 0;
 };
 
+inline void RtpPacket::set_header_seq(const uint32_t _seq)
+{
+    this->header.set_seq(_seq);
+    this->cached_cur_seq = _seq;
+}
+
+inline void RtpPacket::set_header_timestamp(const uint32_t _newtimestamp)
+{
+    this->header.set_timestamp(_newtimestamp);
+    this->cached_cur_timestamp = _newtimestamp;
+}
+
+inline void RtpPacket::set_header_marker(const bool _marker)
+{
+    this->header.set_marker(_marker);
+}
+
 inline uint8_t *RtpPacket::get_payload()
 {
      return this->RTP_Payload;
 }
 
+inline const uint8_t *RtpPacket::get_packet() const
+{
+    return reinterpret_cast<const uint8_t *>(this);
+}
+
 inline uint32_t RtpPacket::get_header_seq()
 {
     return this->cached_cur_seq;
@@ -0,0 +1,77 @@
+#ifndef RTP_PACKETIZER_HPP
+#define RTP_PACKETIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "h264_parser.hpp"
+#include "rtp_packet.hpp"
+#include "common.hpp"
+
+struct PacketizerStats
+{
+    int64_t nals = 0;
+    int64_t packets = 0;
+    int64_t stap_packets = 0;   // STAP-A 패킷 수
+    int64_t stap_nals = 0;      // STAP-A에 담긴 NAL 수
+
+    void print(const char *name) const;
+};
+
+class RtpPacketizer
+{
+public:
+    // 패킷 하나를 받는다: rtpPack의 앞 headLen 바이트(RTP 헤더 + FU 바이트) 뒤에
+    // NAL 안의 payload를 복사 없이 이어 붙인 것. 처리한 바이트 수를 돌려주고 음수면 실패.
+    // STAP-A는 작은 NAL들을 rtpPack 안에 복사해 두므로 payload 없이 headLen만 넘긴다
+    using Sink = std::function<int64_t(RtpPacket &rtpPack, int64_t headLen,
+                                       const uint8_t *payload, int64_t payloadLen)>;
+
+    explicit RtpPacketizer(int64_t mtu = DEFAULT_PATH_MTU);
+
+    void set_mtu(int64_t mtu);
+    int64_t get_mtu() const;
+    int64_t get_max_payload_size() const;
+    // 같은 access unit의 연속된 작은 NAL을 STAP-A 하나로 묶는다 (RFC 6184 5.7.1)
+    void set_aggregation(bool enabled);
+    bool get_aggregation() const;
+
+    // marker면 NAL의 마지막 패킷에 marker bit를 세운다 (access unit의 마지막 NAL)
+    int64_t packetize(RtpPacket &rtpPack, const uint8_t *nal,
+                      int64_t nalSize, const Sink &sink, bool marker = true) const;
+    // access unit 하나의 모든 패킷은 rtpPack의 현재 timestamp를 같이 쓴다
+    int64_t packetize_access_unit(RtpPacket &rtpPack, const std::vector<NalUnit> &nals,
+                                  const Sink &sink, PacketizerStats *stats = nullptr) const;
+
+private:
+    int64_t mtu = DEFAULT_PATH_MTU;
+    int64_t max_payload_size = 0;
+    bool aggregation = true;
+
+    int64_t aggregate(RtpPacket &rtpPack, const NalUnit *nals, int64_t count,
+                      const Sink &sink, bool marker) const;
+};
+
+inline int64_t RtpPacketizer::get_mtu() const
+{
+    return this->mtu;
+}
+
+inline int64_t RtpPacketizer::get_max_payload_size() const
+{
+    return this->max_payload_size;
+}
+
+inline void RtpPacketizer::set_aggregation(const bool enabled)
+{
+    this->aggregation = enabled;
+}
+
+inline bool RtpPacketizer::get_aggregation() const
+{
+    return this->aggregation;
+}
+
+#endif //RTP_PACKETIZER_HPP
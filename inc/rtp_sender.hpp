@@ -0,0 +1,122 @@
+#ifndef RTP_SENDER_HPP
+#define RTP_SENDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+enum class SendMode
+{
+    SENDTO,
+    SENDMMSG,
+    GSO,        // UDP_SEGMENT: 같은 크기의 패킷을 커널이 나눠서 보낸다
+};
+
+struct RtpSendStats
+{
+    int64_t frames = 0;
+    int64_t packets = 0;
+    int64_t bytes = 0;
+    int64_t syscalls = 0;
+    int64_t errors = 0;
+    int64_t dropped_frames = 0;     // 혼잡해서 보내지 않은 프레임
+
+    double syscalls_per_frame() const;
+    void print(const char *name) const;
+};
+
+// 보낼 패킷 하나. 헤더(RTP 헤더 + FU 바이트)는 복사해 두고 페이로드는 원본을 가리킨다
+struct RtpPacketRef
+{
+    int64_t headOffset;
+    int64_t headLen;
+    const uint8_t *payload;
+    int64_t payloadLen;
+};
+
+// 한 프레임(NAL 또는 access unit)의 패킷을 모아 두었다가 한 번에 보낸다
+class RtpSender
+{
+public:
+    explicit RtpSender(SendMode mode = SendMode::SENDMMSG);
+
+    void set_mode(SendMode mode);
+    SendMode get_mode() const;
+    bool is_gso_available() const;
+
+    void push(const uint8_t *head, int64_t headLen,
+              const uint8_t *payload = nullptr, int64_t payloadLen = 0);
+    // 페이로드가 가리키는 버퍼를 다 보낼 때까지 살려 둔다
+    void hold(std::shared_ptr<const void> owner);
+    // SO_TXTIME이 켜진 소켓에서 패킷마다 [startNs, startNs + spanNs) 사이의 송신 시각을 붙인다
+    void set_txtime(int64_t startNs, int64_t spanNs);
+
+    int64_t flush(int sockfd, const sockaddr_in &to, RtpSendStats &stats);
+    // 앞에서부터 count번째 패킷까지만 보낸다. 나머지는 다음 호출까지 남겨 둔다
+    int64_t flush_until(int sockfd, const sockaddr_in &to, RtpSendStats &stats, int64_t count);
+    // RTSP TCP 연결로 '$' channel length 를 붙여 보낸다 (RFC 2326 10.12).
+    // 소켓 버퍼가 차서 못 쓴 나머지는 backlog 뒤에 복사한다. backlog가 비어 있지 않으면 바로 복사한다
+    int64_t flush_interleaved(int sockfd, uint8_t channel, std::vector<uint8_t> &backlog,
+                              RtpSendStats &stats);
+    void clear();
+
+    int64_t get_packet_count() const;
+    int64_t get_sent_packets() const;
+    int64_t get_pending_packets() const;
+
+    static bool enable_txtime(int sockfd);
+
+private:
+    SendMode mode;
+    bool gso_available = true;
+    std::vector<uint8_t> head_buffer;
+    std::vector<RtpPacketRef> packets;
+    std::vector<iovec> iovecs;
+    std::vector<mmsghdr> msgs;
+    std::vector<char> controls;
+    std::vector<uint8_t> prefixes;
+    std::vector<std::shared_ptr<const void>> owners;
+    int64_t sent_packets = 0;
+    int64_t txtime_start = 0;
+    int64_t txtime_span = 0;
+
+    int64_t flush_sendto(int sockfd, const sockaddr_in &to, RtpSendStats &stats,
+                         int64_t first, int64_t last);
+    int64_t flush_sendmmsg(int sockfd, const sockaddr_in &to, RtpSendStats &stats,
+                           int64_t first, int64_t last);
+    int64_t flush_gso(int sockfd, const sockaddr_in &to, RtpSendStats &stats,
+                      int64_t first, int64_t last);
+    int64_t packet_len(int64_t index) const;
+    int64_t fill_iovecs(int64_t index, iovec *iov) const;
+};
+
+inline SendMode RtpSender::get_mode() const
+{
+    return this->mode;
+}
+
+inline bool RtpSender::is_gso_available() const
+{
+    return this->gso_available;
+}
+
+inline int64_t RtpSender::get_packet_count() const
+{
+    return this->packets.size();
+}
+
+inline int64_t RtpSender::get_sent_packets() const
+{
+    return this->sent_packets;
+}
+
+inline int64_t RtpSender::get_pending_packets() const
+{
+    return this->packets.size() - this->sent_packets;
+}
+
+#endif //RTP_SENDER_HPP
@@ -3,23 +3,27 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
-#include <queue>
-#include <condition_variable>
 
+#include "bounded_queue.hpp"
 #include "rtp_packet.hpp"
 #include "h264_parser.hpp"
+#include "h264_encoder.hpp"
+#include "frame_ring.hpp"
+#include "frame_source.hpp"
+#include "rate_controller.hpp"
+#include "rtsp_server.hpp"
+#include "segment_recorder.hpp"
+#include "stage_stats.hpp"
 #include "common.hpp"
 
-struct Buffer {
-    void *start;
-    size_t length;
-};
-
-extern Buffer *buffers;
-extern unsigned int n_buffers;
-
 struct YUV420Buffer {
     unsigned char *y_data[FRAME_COUNT];
     unsigned char *u_data[FRAME_COUNT];
@@ -28,46 +32,96 @@ struct YUV420Buffer {
     std::mutex lock;
 };
 
-struct YUV420Frame {
-    std::vector<unsigned char> y_data;
-    std::vector<unsigned char> u_data;
-    std::vector<unsigned char> v_data;
-};
-
 // 전역 YUV420 버퍼
 extern YUV420Buffer yuv420_buffer;
 
-class RTSPCam
+// 인코딩 단계가 송신/녹화 단계로 넘기는 항목
+struct EncodedItem {
+    EncodedPacketPtr packet;
+    uint32_t timeStampStep = 0;
+    int64_t capture_ns = 0;     // RTP timestamp는 캡처 시각으로 정한다
+    int64_t enqueued_ns = 0;
+};
+
+class RTSPCam : public RtspServer
 {
 public:
-    explicit RTSPCam();
-    ~RTSPCam();
+    explicit RTSPCam(std::unique_ptr<FrameSource> source);
+    ~RTSPCam() override;
 
+    // 스스로 frame rate를 맞추지 않는 소스(synthetic, file)를 읽는 간격. 0이면 최대한 빠르게 읽는다
+    void set_capture_fps(double fps);
     void capture_frames();
     void Start(int ssrcNum, const char *sessionID, int timeout, float fps = 30);
 
-    std::queue<YUV420Frame> frame_queue; // 캡처된 프레임 큐
-    std::mutex queue_mutex;             // 큐 동기화를 위한 뮤텍스
-    std::condition_variable queue_cond; // 큐 조건 변수
+    // 파이프라인: 캡처/변환(capture_frames 스레드) -> frame_ring -> 인코딩(encode_thread)
+    //   -> send_queue -> 패킷화/송신(이벤트 루프)
+    //   -> record_queue -> 녹화(record_thread)
+    // 뒤 단계의 큐가 가득 차면 기다리지 않고 다음 IDR까지 버리므로 느린 송신이 인코더를 막지 않는다
+    FrameRing frame_ring{CAM_FRAME_RING_DEPTH, WIDTH * HEIGHT * 3 / 2}; // 캡처된 I420 프레임
+    int frame_event_fd{-1};             // 새 프레임 도착을 인코딩 스레드에 알림
     
 private:
-
-    int pts = 1;
-    
-    int server_rtsp_sock_fd{-1};
-    int server_rtp_sock_fd{-1};
-    int server_rtcp_sock_fd{-1};
-
-    int client_rtp_port{-1};
-    int client_rtcp_port{-1};
-
-    void init_device(int fd);
-    void init_mmap(int fd);
-
-    void serve_client(int clientfd, const sockaddr_in &cliAddr, int rtpFD,
-                      int ssrcNum,  const char *sessionID,      int timeout, float fps);
-
-    static int64_t push_stream(int sockfd, RtpPacket &rtpPack, const uint8_t *data, int64_t dataSize, const sockaddr *to, uint32_t timeStampStep);
+    std::unique_ptr<FrameSource> source;
+    double capture_fps = 30;
+    StageStats convert_stats;           // 캡처 스레드만 쓴다
+
+    // 인코딩 스레드만 쓴다
+    std::thread encode_thread;
+    H264Encoder encoder;                // 모든 세션이 공유하는 인코더
+    bool encoder_failed = false;
+    int64_t captured_frames = 0;
+    bool send_wait_idr = false;
+    bool record_wait_idr = false;
+    StageStats encode_stats;
+
+    // 이벤트 루프가 바꾸고 인코딩 스레드가 읽는다
+    std::atomic<bool> running{true};
+    std::atomic<int> viewers{0};
+    std::atomic<bool> keyframe_requested{false};
+    std::atomic<int64_t> target_bitrate{CAM_START_BIT_RATE};
+    std::atomic<int> frame_divisor{1};
+
+    BoundedQueue<EncodedItem> send_queue{CAM_SEND_QUEUE_DEPTH};
+    int packet_event_fd{-1};            // 새 인코딩 결과를 이벤트 루프에 알림
+    StageStats send_stats;              // 이벤트 루프만 쓴다
+
+    BoundedQueue<EncodedItem> record_queue{CAM_RECORD_QUEUE_DEPTH};
+    std::thread record_thread;
+    std::atomic<bool> recording{true};  // 녹화 파일을 쓰지 못하면 녹화 단계를 건너뛴다
+    SegmentRecorder recorder{RECORD_PREFIX, CAM_RECORD_SEGMENT_SECONDS * 1000000000,
+                             CAM_RECORD_SEGMENT_BYTES, CAM_RECORD_DIRECT_IO,
+                             CAM_RECORD_WRITE_BUFFER};
+    StageStats record_stats;            // 녹화 스레드만 쓴다
+
+    // 이벤트 루프만 쓴다
+    RateController rate_controller{CAM_MIN_BIT_RATE, CAM_MAX_BIT_RATE, CAM_START_BIT_RATE};
+    RateSample rate_sample;             // 지난 조절 이후 받은 RTCP 보고 중 가장 나쁜 값. 주기마다 비운다
+    int64_t dropped_frames_total = 0;
+
+    // 이벤트 루프만 쓴다. 마지막 IDR부터의 인코더 출력을 참조 카운트로 들고 있다가
+    // 중간에 들어온 시청자에게 먼저 보내서 다음 IDR을 기다리지 않게 한다
+    std::vector<EncodedItem> gop_cache;
+    int64_t gop_cache_bytes = 0;
+    std::map<int, std::deque<EncodedItem>> gop_bursts;  // 세션 fd -> 아직 못 보낸 GOP와 그 뒤 프레임
+    int gop_burst_timer_fd{-1};
+
+    void on_play(RtspSession &session) override;
+    void on_keyframe_needed(RtspSession &session) override;
+    void on_receiver_report(RtspSession &session) override;
+    void on_close(RtspSession &session) override;
+    void update_viewers(const RtspSession *closing);
+    void update_rate();
+
+    void encode_loop();
+    void encode_frame(const uint8_t *capframe, int64_t captureNs, int64_t depth);
+    bool hand_over(BoundedQueue<EncodedItem> &queue, bool &waitIdr, const EncodedItem &item);
+    void on_packets_ready();
+    void push_item(RtspSession &session, const EncodedItem &item);
+    void update_parameter_sets(const EncodedPacket &pkt);
+    void cache_gop(const EncodedItem &item);
+    int64_t send_gop_burst();
+    void record_loop();
 };
 
 #endif //RTSP_CAM_HPP
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef RTSP_PARSER_HPP
+#define RTSP_PARSER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// 받은 버퍼 안의 일부를 복사 없이 가리킨다. NUL로 끝나지 않는다
+struct StrView
+{
+    const char *data = nullptr;
+    int64_t size = 0;
+
+    StrView() = default;
+    StrView(const char *data, int64_t size) : data(data), size(size) {}
+
+    bool empty() const { return this->size == 0; }
+    bool equals(const char *str) const;
+    // 헤더 이름처럼 대소문자를 구분하지 않는다
+    bool iequals(const char *str) const;
+    // 없으면 -1
+    int64_t find(const char *str, int64_t from = 0) const;
+    int64_t find(char ch, int64_t from = 0) const;
+    StrView substr(int64_t pos, int64_t len = -1) const;
+    StrView trim() const;
+    // 앞에서부터 10진수를 읽고 읽은 글자 수를 돌려준다. 숫자가 없거나 9자리를 넘으면 0
+    int64_t parse_int(int64_t &value) const;
+    // npt 초처럼 숫자와 '.' 하나만 읽는다 (부호, 지수, inf/nan 없음). 정수부가 9자리를 넘거나
+    // 숫자 바로 뒤에 글자나 '.'이 이어지면 false
+    bool to_double(double &value) const;
+};
+
+struct RtspHeader
+{
+    StrView name;
+    StrView value;
+};
+
+// 요청 하나. 모든 StrView는 파싱한 버퍼를 가리키므로 버퍼를 옮기기 전까지만 유효하다
+struct RtspRequest
+{
+    static constexpr int MAX_HEADERS = 32;
+
+    StrView raw;                // 요청 줄부터 빈 줄까지 (로그용)
+    StrView method;
+    StrView url;
+    StrView version;
+    RtspHeader headers[MAX_HEADERS];
+    int header_count = 0;
+    int64_t cseq = -1;
+    StrView body;
+
+    // interleaved '$' 프레임이면 channel과 body만 채운다
+    int channel = -1;
+
+    StrView get_header(const char *name) const;
+};
+
+// RTSP 요청과 interleaved 프레임을 버퍼에서 바로 해석한다. 메모리를 할당하지 않는다.
+// 한 번의 recv에 요청이 잘려 오거나 여러 요청이 이어 와도 된다
+class RtspParser
+{
+public:
+    enum class Result
+    {
+        INCOMPLETE,     // 더 받아야 한다. 이어 받은 뒤 같은 위치부터 다시 부른다
+        REQUEST,
+        INTERLEAVED,
+        ERROR,
+    };
+
+    // data[0, len)의 맨 앞 메시지 하나를 해석한다. INCOMPLETE, ERROR가 아니면 consumed에 그 길이.
+    // 이미 훑은 부분은 다음 호출에서 다시 훑지 않는다
+    Result parse(const char *data, int64_t len, RtspRequest &request, int64_t &consumed);
+    void reset();
+
+    // "RTP/AVP;unicast;client_port=4588-4589" 에서 key의 값("4588-4589"). 없으면 빈 값
+    static StrView get_param(StrView value, const char *key);
+    // "4588-4589" 같은 값. 두 번째 숫자가 없으면 second = first + 1
+    static bool get_param_pair(StrView value, const char *key, int64_t &first, int64_t &second);
+
+private:
+    int64_t scanned = 0;    // 메시지 시작부터 빈 줄을 찾느라 이미 훑은 길이
+
+    Result parse_request(const char *data, int64_t headerLen, int64_t len,
+                         RtspRequest &request, int64_t &consumed);
+};
+
+#endif //RTSP_PARSER_HPP
\ No newline at end of file
@@ -0,0 +1,129 @@
+#ifndef RTSP_SERVER_HPP
+#define RTSP_SERVER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "event_loop.hpp"
+#include "rtp_packetizer.hpp"
+#include "rtp_sender.hpp"
+#include "rtsp_parser.hpp"
+#include "rtsp_session.hpp"
+#include "timer_wheel.hpp"
+
+class RtspServer
+{
+public:
+    RtspServer() = default;
+    virtual ~RtspServer();
+
+    RtspServer(const RtspServer &) = delete;
+    RtspServer &operator=(const RtspServer &) = delete;
+
+    void set_mtu(int64_t mtu);
+    void set_send_mode(SendMode mode);
+    void set_aggregation(bool enabled);
+    // 한 프레임의 패킷을 slices번에 나눠 프레임 주기 동안 고르게 보낸다. 1이면 한 번에 보낸다.
+    // 0(기본값)이면 프레임의 패킷 수에 맞춰 정하므로 큰 I-frame만 나눠 보낸다
+    void set_pacing(int slices);
+    // SO_TXTIME으로 패킷마다 송신 시각을 붙여 커널(fq qdisc)이 간격을 맞추게 한다
+    void set_txtime(bool enabled);
+    // multicast SETUP에 알려 줄 그룹 주소, RTP 포트(RTCP는 +1), TTL
+    bool set_multicast(const char *group, uint16_t port, int ttl);
+
+protected:
+    EventLoop loop;
+
+    int server_rtsp_sock_fd{-1};
+    int server_rtp_sock_fd{-1};
+    int server_rtcp_sock_fd{-1};
+
+    int ssrcNum = 0;
+    int rtxSsrcNum = 0;
+    const char *session_prefix = nullptr;
+    int timeout = 0;    // 초. 0이면 idle 세션을 끊지 않는다
+    float fps = 30;
+
+    // multicast 그룹은 MULTICAST_SESSION_KEY로 들어 있는 세션 하나가 모든 구성원 대신 보낸다
+    static constexpr int MULTICAST_SESSION_KEY = -1;
+    std::map<int, std::unique_ptr<RtspSession>> sessions;
+    RtpPacketizer packetizer;
+    SendMode send_mode = SendMode::SENDMMSG;
+    std::vector<NalUnit> nal_units;
+
+    int pace_slices = 0;
+    int pace_frame_slices = 1;  // 지금 보내는 프레임을 나눈 조각 수
+    bool txtime = false;
+    int pace_timer_fd{-1};
+    int64_t pace_frame_start = 0;
+    int pace_next_slice = 0;
+
+    // sessionID는 SETUP마다 만드는 세션 ID의 앞부분이다
+    void init(int ssrcNum, const char *sessionID, int timeout, float fps);
+    // 스트림의 SPS/PPS(start code 제외). 바뀌었을 때만 DESCRIBE에 쓸 SDP를 다시 만든다
+    void set_parameter_sets(const uint8_t *sps, int64_t spsLen,
+                            const uint8_t *pps, int64_t ppsLen);
+    // accessUnit은 start code가 붙은 Annex B 형태의 한 프레임. 패킷을 세션에 쌓기만 하고
+    // 보내는 것은 flush_streams()가 한다. owner는 보낼 때까지 accessUnit을 살려 둔다
+    int64_t push_stream(RtspSession &session, const uint8_t *accessUnit,
+                        int64_t accessUnitSize, uint32_t timeStampStep,
+                        std::shared_ptr<const void> owner = nullptr);
+    // frameStartNs(CLOCK_MONOTONIC)부터 한 프레임 주기 동안 쌓인 패킷을 내보낸다
+    void flush_streams(int64_t frameStartNs);
+    // 한 세션에 쌓인 패킷만 바로 보낸다. 다른 세션의 pacing 상태는 건드리지 않는다
+    void flush_session(RtspSession &session);
+
+    virtual void on_play(RtspSession &session);
+    // 혼잡으로 참조 프레임을 버려서 새 IDR이 필요할 때 부른다
+    virtual void on_keyframe_needed(RtspSession &session);
+    // 수신자 RTCP 보고로 session.rtcpStats가 갱신된 뒤 부른다
+    virtual void on_receiver_report(RtspSession &session);
+    // PLAY의 Range 요청(npt 초, 없으면 음수)을 처리하고 실제 시작 위치를 돌려준다
+    virtual double on_seek(RtspSession &session, double npt);
+    virtual void on_close(RtspSession &session);
+
+private:
+    sockaddr_in multicast_addr{};
+    int multicast_ttl = MULTICAST_DEFAULT_TTL;
+    int multicast_members = 0;
+
+    std::vector<uint8_t> sps;
+    std::vector<uint8_t> pps;
+    std::string sdp_media;      // 스트림마다 한 번 만들어 두고 DESCRIBE마다 붙인다
+
+    // 세션 ID -> RTSP 연결(sessions의 key). 다른 연결에서 온 keepalive와 TEARDOWN도 찾는다
+    std::map<std::string, int> session_ids;
+    TimerWheel session_wheel{RTSP_SESSION_TICK_MS * 1000 * 1000, RTSP_SESSION_WHEEL_SLOTS};
+    std::random_device session_random;
+    uint64_t next_session_serial = 0;
+
+    void accept_clients();
+    void read_client(int clientfd);
+    void write_client(int clientfd);
+    bool send_reply(RtspSession &session, const char *data, int64_t dataLen);
+    void update_write_interest(RtspSession &session);
+    bool should_drop_frame(RtspSession &session, bool isIdr, bool isReference);
+    bool send_interleaved(RtspSession &session, uint8_t channel,
+                          const uint8_t *data, int64_t dataLen);
+
+    void read_rtcp();
+    void handle_rtcp(RtspSession &session, const uint8_t *data, int64_t dataLen);
+    void send_sender_reports();
+    void retransmit(RtspSession &session, const std::vector<uint16_t> &seqs);
+    bool handle_request(RtspSession &session, const RtspRequest &request);
+    void close_session(int clientfd);
+    void assign_session_id(RtspSession &session);
+    RtspSession *find_session(StrView sessionHeader);
+    void reap_sessions();
+    void print_session_stats(const RtspSession &session) const;
+    bool join_multicast(RtspSession &session);
+    void leave_multicast(RtspSession &session);
+    int64_t send_slice();
+};
+
+#endif //RTSP_SERVER_HPP
@@ -0,0 +1,83 @@
+#ifndef RTSP_SESSION_HPP
+#define RTSP_SESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+#include "rtcp.hpp"
+#include "rtp_packet.hpp"
+#include "rtp_packetizer.hpp"
+#include "rtp_sender.hpp"
+#include "rtsp_parser.hpp"
+#include "rtx_cache.hpp"
+#include "common.hpp"
+
+enum class SessionState
+{
+    INIT,
+    READY,
+    PLAYING,
+};
+
+struct RtspSession
+{
+    RtspSession(int _fd, const sockaddr_in &_cliAddr) : fd(_fd), cliAddr(_cliAddr) {}
+
+    int fd;
+    sockaddr_in cliAddr;
+    SessionState state = SessionState::INIT;
+
+    std::string session_id;         // SETUP에서 정한다. 그 전에는 비어 있다
+    uint64_t serial = 0;            // fd가 다시 쓰여도 timer wheel 항목을 구별한다
+    int64_t last_active_ns = 0;     // 마지막으로 요청이나 RTCP를 받은 시각
+
+    char recvBuf[RTSP_RECV_BUF_SIZE]{0};
+    int64_t recvLen = 0;
+    RtspParser parser;
+
+    int client_rtp_port{-1};
+    int client_rtcp_port{-1};
+    sockaddr_in rtpAddr{};
+
+    // RTP/AVP;multicast: 직접 보내지 않고 그룹 세션이 한 번 보낸 것을 같이 받는다
+    bool multicast = false;
+    bool multicast_joined = false;
+
+    // RTP/AVP/TCP: RTP를 RTSP 연결에 '$' 프레임으로 끼워 보낸다
+    bool interleaved = false;
+    uint8_t rtp_channel = 0;
+    uint8_t rtcp_channel = 1;
+    std::vector<uint8_t> sendBuf;   // 소켓에 다 못 쓴 응답과 RTP
+    int64_t sendOffset = 0;         // sendBuf에서 이미 보낸 길이. 다 보내면 sendBuf와 같이 비운다
+    bool want_write = false;
+    bool wait_idr = false;          // 참조 프레임을 버렸으면 다음 IDR까지 버린다
+
+    std::unique_ptr<RtpPacket> rtpPack;
+    RtpSender sender;
+    RtpSendStats sendStats;
+    PacketizerStats packStats;
+
+    // Sender Report에 넣을 값
+    uint32_t rtp_packet_count = 0;
+    uint32_t rtp_octet_count = 0;
+    uint32_t last_rtp_timestamp = 0;    // 마지막으로 보낸 프레임의 RTP timestamp
+    int64_t last_rtp_time = 0;          // 그 프레임을 보낸 CLOCK_MONOTONIC 시각
+    RtcpStats rtcpStats;
+
+    // NACK을 받으면 RTX(PT 97)로 다시 보낸다. TCP는 잃어버리지 않으므로 UDP만 쓴다
+    RtxCache rtxCache;
+    RtxStats rtxStats;
+    uint16_t rtx_seq = 0;
+    int64_t get_send_backlog() const { return int64_t(this->sendBuf.size()) - this->sendOffset; }
+
+    int64_t frame_index = 0;    // 파일 스트리밍에서 다음에 보낼 access unit 번호
+    // 카메라 스트리밍: 이 세션에 처음 보낸 프레임의 캡처 시각과 RTP timestamp
+    int64_t capture_base_ns = 0;
+    uint32_t rtp_base_timestamp = 0;
+};
+
+#endif //RTSP_SESSION_HPP
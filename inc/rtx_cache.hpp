@@ -0,0 +1,54 @@
+#ifndef RTX_CACHE_HPP
+#define RTX_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct RtxStats
+{
+    int64_t nacks = 0;          // 받은 NACK 피드백 메시지 수
+    int64_t requested = 0;      // 요청된 패킷 수
+    int64_t hits = 0;           // 다시 보낸 패킷 수
+    int64_t misses = 0;         // 이미 덮어써서 보낼 수 없던 패킷 수
+    int64_t bytes = 0;
+
+    void print(const char *name) const;
+};
+
+// 최근에 보낸 RTP 패킷을 sequence number로 찾을 수 있게 복사해 두는 ring buffer.
+// 슬롯 수는 2의 거듭제곱이고 seq의 하위 비트가 슬롯 위치다. 처음 store할 때 메모리를 잡는다
+class RtxCache
+{
+public:
+    // budget 바이트 안에서 slotSize 크기의 슬롯을 가능한 만큼 잡는다
+    void reset(int64_t budget, int64_t slotSize);
+
+    // head(RTP 헤더 + FU/STAP-A) 뒤에 payload를 붙여 저장한다. 슬롯보다 크면 저장하지 않는다
+    void store(uint16_t seq, const uint8_t *head, int64_t headLen,
+               const uint8_t *payload, int64_t payloadLen);
+    // 아직 덮어쓰지 않았으면 저장한 RTP 패킷을 돌려준다. 없으면 nullptr
+    const uint8_t *find(uint16_t seq, int64_t &len) const;
+
+    bool is_allocated() const;
+    int64_t get_memory_size() const;
+
+private:
+    std::vector<uint8_t> storage;
+    std::vector<int64_t> lengths;   // 0이면 빈 슬롯
+    std::vector<uint16_t> seqs;
+    int64_t slot_size = 0;
+    uint16_t slot_mask = 0;
+};
+
+inline bool RtxCache::is_allocated() const
+{
+    return !this->lengths.empty();
+}
+
+inline int64_t RtxCache::get_memory_size() const
+{
+    return this->storage.size();
+}
+
+#endif //RTX_CACHE_HPP
@@ -0,0 +1,92 @@
+#ifndef SEGMENT_RECORDER_HPP
+#define SEGMENT_RECORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma pack(1)
+
+// 세그먼트 인덱스(<prefix>_NNNNN.idx)의 항목 하나 = 인코더 출력 하나
+struct SegmentIndexEntry
+{
+    int64_t offset;        // 세그먼트 파일 안의 위치
+    int64_t size;
+    int64_t timeNs;        // 세그먼트 시작부터 지난 시간
+    uint8_t keyframe;
+};
+
+#pragma pack()
+
+struct RecorderStats
+{
+    int64_t segments = 0;
+    int64_t frames = 0;
+    int64_t bytes = 0;
+    int64_t skipped = 0;        // 첫 IDR 전이라 버린 프레임
+    int64_t writes = 0;         // write() 호출 수
+    double write_sum = 0;       // us
+    double write_max = 0;
+
+    void print(const char *name) const;
+};
+
+// 인코더 출력을 크기나 시간 단위 세그먼트 파일로 나눠 쓴다.
+// 세그먼트는 항상 SPS/PPS가 붙은 IDR로 시작하고, 닫을 때 프레임 위치 인덱스를 남긴다.
+// 정렬된 큰 버퍼에 모아서 쓰므로 write() 호출이 적고, directIo면 O_DIRECT로 page cache를 거치지 않는다.
+// 한 스레드(녹화 스레드)만 쓴다
+class SegmentRecorder
+{
+public:
+    SegmentRecorder(const std::string &prefix, int64_t maxDurationNs, int64_t maxBytes,
+                    bool directIo = false, int64_t bufferSize = 1024 * 1024);
+    ~SegmentRecorder();
+
+    SegmentRecorder(const SegmentRecorder &) = delete;
+    SegmentRecorder &operator=(const SegmentRecorder &) = delete;
+
+    // 인코더 출력 한 개(access unit)를 쓴다. 실패하면 false
+    bool write(const uint8_t *data, int64_t size, bool keyframe, int64_t timeNs);
+    // 버퍼를 비우고 세그먼트와 인덱스를 닫는다
+    bool close();
+
+    const RecorderStats &get_stats() const;
+
+private:
+    static constexpr int64_t DIRECT_IO_ALIGN = 4096;
+
+    std::string prefix;
+    int64_t max_duration_ns;
+    int64_t max_bytes;
+    bool direct_io;
+
+    uint8_t *buffer = nullptr;          // DIRECT_IO_ALIGN 정렬
+    int64_t buffer_size;
+    int64_t buffer_len = 0;
+
+    int fd = -1;
+    int64_t segment_num = 0;
+    int64_t segment_start_ns = 0;
+    int64_t segment_bytes = 0;
+    std::vector<SegmentIndexEntry> entries;
+
+    std::vector<uint8_t> sps;           // start code 포함, 마지막으로 본 것
+    std::vector<uint8_t> pps;
+    RecorderStats stats;
+
+    bool open_segment(int64_t timeNs);
+    bool close_segment();
+    bool append(const uint8_t *data, int64_t size);
+    bool flush_buffer(bool last);
+    bool save_index() const;
+    std::string segment_path(const char *ext) const;
+    bool scan_parameter_sets(const uint8_t *data, int64_t size);
+};
+
+inline const RecorderStats &SegmentRecorder::get_stats() const
+{
+    return this->stats;
+}
+
+#endif //SEGMENT_RECORDER_HPP
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef STAGE_STATS_HPP
+#define STAGE_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// 파이프라인 한 단계의 통계. 그 단계의 스레드만 갱신한다
+struct StageStats
+{
+    int64_t items = 0;
+    int64_t dropped = 0;        // 다음 단계 큐가 가득 차서 넘기지 못한 항목
+    double wait_sum = 0;        // us, 앞 단계에서 넘겨받기까지 기다린 시간
+    double wait_max = 0;
+    double work_sum = 0;        // us, 이 단계에서 처리한 시간
+    double work_max = 0;
+    int64_t depth_sum = 0;      // 꺼낼 때 앞 큐에 쌓여 있던 항목 수
+    int64_t depth_max = 0;
+
+    void add(int64_t waitNs, int64_t workNs, int64_t depth);
+    void print(const char *name) const;
+};
+
+#endif //STAGE_STATS_HPP
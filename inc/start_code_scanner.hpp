@@ -0,0 +1,43 @@
+#ifndef START_CODE_SCANNER_HPP
+#define START_CODE_SCANNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// 00 00 01 / 00 00 00 01 start code 탐색. CPU에 맞는 구현을 실행 시점에 고른다
+class StartCodeScanner
+{
+public:
+    enum class Impl
+    {
+        SCALAR,
+        SSE2,
+        AVX2,
+    };
+
+    // 가장 앞의 start code 위치(4바이트 start code면 첫 00 위치)를 돌려준다. 없으면 nullptr
+    static const uint8_t *find(const uint8_t *buffer, int64_t bufLen);
+
+    static const uint8_t *find_scalar(const uint8_t *buffer, int64_t bufLen);
+    static const uint8_t *find_sse2(const uint8_t *buffer, int64_t bufLen);
+    static const uint8_t *find_avx2(const uint8_t *buffer, int64_t bufLen);
+
+    static bool is_supported(Impl impl);
+    static Impl get_impl();
+    static bool set_impl(Impl impl);
+    static const char *impl_name(Impl impl);
+
+private:
+    using FindFunc = const uint8_t *(*)(const uint8_t *, int64_t);
+    static FindFunc find_func;
+    static Impl impl;
+
+    static Impl detect();
+};
+
+inline const uint8_t *StartCodeScanner::find(const uint8_t *buffer, const int64_t bufLen)
+{
+    return StartCodeScanner::find_func(buffer, bufLen);
+}
+
+#endif //START_CODE_SCANNER_HPP
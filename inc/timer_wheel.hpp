@@ -0,0 +1,44 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TimerWheelEntry
+{
+    int key;
+    uint64_t token;         // 같은 key(fd)가 다시 쓰였을 때 예전 항목을 구별한다
+    int64_t deadline_ns;
+};
+
+// tick 단위 슬롯을 도는 hashed timer wheel. 항목은 deadline이 든 슬롯에 들어가고,
+// 슬롯 수 * tick보다 먼 deadline은 한 바퀴 돌 때마다 다시 본다.
+// 취소나 연장은 하지 않는다. 만료된 항목을 받은 쪽이 실제 상태를 보고 다시 넣거나 버린다
+class TimerWheel
+{
+public:
+    TimerWheel(int64_t tickNs, int64_t slots);
+
+    void start(int64_t nowNs);
+    void add(int key, uint64_t token, int64_t deadlineNs);
+    // nowNs까지 지난 슬롯을 돌며 deadline이 지난 항목을 expired에 담는다
+    void advance(int64_t nowNs, std::vector<TimerWheelEntry> &expired);
+
+    int64_t get_size() const;
+
+private:
+    int64_t tick_ns;
+    std::vector<std::vector<TimerWheelEntry>> slots;
+    int64_t current_tick = 0;   // 다음에 볼 슬롯의 tick 번호
+    int64_t size = 0;
+
+    std::vector<TimerWheelEntry> pending;   // advance 중에 다시 넣을 항목
+};
+
+inline int64_t TimerWheel::get_size() const
+{
+    return this->size;
+}
+
+#endif //TIMER_WHEEL_HPP
\ No newline at end of file
@@ -10,7 +10,11 @@ public:
     static int  Socket(int domain, int type, int protocol = 0);
     static bool Bind(int sockfd, const char *IP, uint16_t port);
     static bool Listen(int sockfd, int64_t ListenQueue = 5);
+    static bool SetNonBlocking(int sockfd);
+    static bool SetMulticastTtl(int sockfd, int ttl);
     static void xioctl(int fd, int request, void *arg);
+    // dst에 NUL까지 써서 base64 길이를 돌려준다. dst가 작으면 -1
+    static int64_t Base64Encode(const uint8_t *src, int64_t srcLen, char *dst, int64_t dstLen);
 };
 
 #endif //UTILS_HPP
\ No newline at end of file
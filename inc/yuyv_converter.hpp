@@ -0,0 +1,61 @@
+#ifndef YUYV_CONVERTER_HPP
+#define YUYV_CONVERTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// 같은 해상도의 YUYV(4:2:2 packed) -> I420(4:2:0 planar) 변환.
+// Y는 그대로 옮기고 U, V는 위아래 두 줄을 반올림 평균한다. CPU에 맞는 구현을 실행 시점에 고른다
+class YuyvConverter
+{
+public:
+    enum class Impl
+    {
+        SCALAR,
+        SSE2,
+        AVX2,
+        NEON,
+    };
+
+    struct Planes
+    {
+        uint8_t *y;
+        uint8_t *u;
+        uint8_t *v;
+        int yStride;
+        int uvStride;
+    };
+
+    // width는 짝수. height가 홀수면 마지막 줄의 chroma는 그 줄만 쓴다
+    static void convert(const uint8_t *yuyv, int yuyvStride, const Planes &dst,
+                        int width, int height);
+
+    static void convert_scalar(const uint8_t *yuyv, int yuyvStride, const Planes &dst,
+                               int width, int height);
+    static void convert_sse2(const uint8_t *yuyv, int yuyvStride, const Planes &dst,
+                             int width, int height);
+    static void convert_avx2(const uint8_t *yuyv, int yuyvStride, const Planes &dst,
+                             int width, int height);
+    static void convert_neon(const uint8_t *yuyv, int yuyvStride, const Planes &dst,
+                             int width, int height);
+
+    static bool is_supported(Impl impl);
+    static Impl get_impl();
+    static bool set_impl(Impl impl);
+    static const char *impl_name(Impl impl);
+
+private:
+    using ConvertFunc = void (*)(const uint8_t *, int, const Planes &, int, int);
+    static ConvertFunc convert_func;
+    static Impl impl;
+
+    static Impl detect();
+};
+
+inline void YuyvConverter::convert(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                                   const int width, const int height)
+{
+    YuyvConverter::convert_func(yuyv, yuyvStride, dst, width, height);
+}
+
+#endif //YUYV_CONVERTER_HPP
@@ -0,0 +1,180 @@
+#include "event_loop.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+constexpr int MAX_EPOLL_EVENTS = 256;
+
+EventLoop::EventLoop()
+{
+    this->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (this->epoll_fd < 0) {
+        fprintf(stderr, "EventLoop::EventLoop() epoll_create1() failed: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    close(this->epoll_fd);
+}
+
+uint64_t EventLoop::pack_data(const int fd, const uint32_t generation)
+{
+    return (uint64_t(generation) << 32) | uint32_t(fd);
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler handler)
+{
+    const uint32_t generation = ++this->next_generation;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = EventLoop::pack_data(fd, generation);
+    if (epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        fprintf(stderr, "EventLoop::add() epoll_ctl() failed: %s\n", strerror(errno));
+        return false;
+    }
+    this->handlers[fd] = Registration{generation, std::make_shared<Handler>(std::move(handler))};
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events)
+{
+    auto it = this->handlers.find(fd);
+    if (it == this->handlers.end())
+        return false;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = EventLoop::pack_data(fd, it->second.generation);
+    if (epoll_ctl(this->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        fprintf(stderr, "EventLoop::modify() epoll_ctl() failed: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::remove(int fd)
+{
+    epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    this->handlers.erase(fd);
+}
+
+int EventLoop::add_timer(int64_t intervalNs, std::function<void()> handler)
+{
+    int timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0) {
+        fprintf(stderr, "EventLoop::add_timer() timerfd_create() failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    itimerspec spec{};
+    spec.it_interval.tv_sec = intervalNs / 1000000000;
+    spec.it_interval.tv_nsec = intervalNs % 1000000000;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(timerfd, 0, &spec, nullptr) < 0) {
+        fprintf(stderr, "EventLoop::add_timer() timerfd_settime() failed: %s\n", strerror(errno));
+        close(timerfd);
+        return -1;
+    }
+
+    auto ok = this->add(timerfd, EPOLLIN, [timerfd, handler](uint32_t) {
+        uint64_t expirations = 0;
+        if (read(timerfd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            return;
+        handler();
+    });
+    if (!ok) {
+        close(timerfd);
+        return -1;
+    }
+    return timerfd;
+}
+
+int EventLoop::add_deadline_timer(std::function<int64_t()> handler)
+{
+    int timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0) {
+        fprintf(stderr, "EventLoop::add_deadline_timer() timerfd_create() failed: %s\n",
+                strerror(errno));
+        return -1;
+    }
+
+    auto ok = this->add(timerfd, EPOLLIN, [this, timerfd, handler](uint32_t) {
+        uint64_t expirations = 0;
+        if (read(timerfd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            return;
+        const int64_t next = handler();
+        if (next > 0)
+            this->set_deadline(timerfd, next);
+    });
+    if (!ok) {
+        close(timerfd);
+        return -1;
+    }
+    return timerfd;
+}
+
+bool EventLoop::set_deadline(int timerfd, int64_t deadlineNs)
+{
+    // 0이면 타이머를 멈춘다. 이미 지난 시각이면 바로 깨어난다
+    itimerspec spec{};
+    spec.it_value.tv_sec = deadlineNs / 1000000000;
+    spec.it_value.tv_nsec = deadlineNs % 1000000000;
+    if (timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        fprintf(stderr, "EventLoop::set_deadline() timerfd_settime() failed: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int64_t EventLoop::now_ns()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void EventLoop::remove_timer(int timerfd)
+{
+    this->remove(timerfd);
+    close(timerfd);
+}
+
+void EventLoop::run()
+{
+    epoll_event events[MAX_EPOLL_EVENTS];
+    this->running = true;
+    while (this->running) {
+        int n = epoll_wait(this->epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "EventLoop::run() epoll_wait() failed: %s\n", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            // 핸들러 안에서 다른 fd가 제거되거나 닫힌 fd 번호로 새 연결이 등록될 수 있으므로
+            // 매번 다시 조회하고 generation이 다르면 버린다
+            const int fd = int(uint32_t(events[i].data.u64));
+            const auto generation = uint32_t(events[i].data.u64 >> 32);
+            auto it = this->handlers.find(fd);
+            if (it == this->handlers.end() || it->second.generation != generation)
+                continue;
+            std::shared_ptr<Handler> handler = it->second.handler;
+            (*handler)(events[i].events);
+        }
+    }
+}
+
+void EventLoop::stop()
+{
+    this->running = false;
+}
@@ -0,0 +1,68 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+// 이만큼 프레임이 밀리면 따라잡으려고 몰아 보내지 않고 지금부터 다시 센다
+constexpr int64_t MAX_LATE_FRAMES = 4;
+
+double PacerStats::mean_lateness() const
+{
+    return this->frames ? this->lateness_sum / this->frames : 0;
+}
+
+double PacerStats::jitter() const
+{
+    if (!this->frames)
+        return 0;
+    const double mean = this->mean_lateness();
+    return std::sqrt(std::max(0.0, this->lateness_sq_sum / this->frames - mean * mean));
+}
+
+void PacerStats::print(const char *name) const
+{
+    fprintf(stdout,
+            "[%s] frames: %ld, late: %ld, resyncs: %ld, lateness mean: %.1f us, "
+            "max: %.1f us, jitter: %.1f us, drift: %.1f us\n",
+            name, this->frames, this->late_frames, this->resyncs, this->mean_lateness(),
+            this->lateness_max, this->jitter(), this->drift);
+}
+
+FramePacer::FramePacer(const double fps)
+{
+    this->set_fps(fps);
+}
+
+void FramePacer::set_fps(const double fps)
+{
+    this->fps = fps > 0 ? fps : 30;
+}
+
+void FramePacer::start(const int64_t nowNs)
+{
+    this->start_ns = nowNs;
+    this->frame = 0;
+}
+
+void FramePacer::tick(const int64_t nowNs)
+{
+    const int64_t lateNs = nowNs - this->deadline_of(this->frame);
+    const double lateUs = lateNs / 1000.0;
+
+    this->stats.frames++;
+    this->stats.lateness_sum += lateUs;
+    this->stats.lateness_sq_sum += lateUs * lateUs;
+    this->stats.lateness_max = std::max(this->stats.lateness_max, lateUs);
+    this->stats.drift = lateUs;
+    if (lateNs >= this->get_interval())
+        this->stats.late_frames++;
+
+    if (lateNs >= MAX_LATE_FRAMES * this->get_interval()) {
+        this->stats.resyncs++;
+        this->start(nowNs);
+    }
+    this->frame++;
+}
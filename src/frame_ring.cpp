@@ -0,0 +1,87 @@
+#include "frame_ring.hpp"
+
+#include <cstdint>
+#include <cstdio>
+
+void FrameRingStats::print(const char *name) const
+{
+    fprintf(stdout, "[%s] published: %ld, consumed: %ld, overwritten: %ld, skipped: %ld\n",
+            name, this->published, this->consumed, this->overwritten, this->skipped);
+}
+
+FrameRing::FrameRing(const int64_t depth, const int64_t frameSize)
+    : depth(depth < 1 ? 1 : depth), frame_size(frameSize)
+{
+    // 슬롯끼리 cache line을 나눠 쓰지 않게 한다
+    this->slot_stride = (frameSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    const int64_t slotCount = this->depth + 2;
+    this->storage.resize(slotCount * this->slot_stride + CACHE_LINE_SIZE);
+    const auto addr = reinterpret_cast<uintptr_t>(this->storage.data());
+    this->slots_base = this->storage.data() +
+                       (CACHE_LINE_SIZE - addr % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+    this->slot_seqs.assign(slotCount, 0);
+    this->slot_times.assign(slotCount, 0);
+
+    // 슬롯 0, 1은 쓰는 쪽과 읽는 쪽의 여분, 나머지는 빈 칸에 넣어 둔다
+    this->cells.reset(new std::atomic<uint32_t>[this->depth]);
+    for (int64_t i = 0; i < this->depth; i++)
+        this->cells[i].store(uint32_t(i + 2), std::memory_order_relaxed);
+}
+
+void FrameRing::publish(const int64_t timestampNs)
+{
+    const uint64_t seq = this->tail.load(std::memory_order_relaxed);
+    this->slot_seqs[this->write_slot] = seq;
+    this->slot_times[this->write_slot] = timestampNs;
+
+    // 슬롯 내용과 번호가 칸을 가져간 읽는 쪽에 보이도록 release
+    const uint32_t old = this->cells[seq % this->depth].exchange(this->write_slot | FRESH,
+                                                                 std::memory_order_acq_rel);
+    if (old & FRESH)
+        this->overwritten.fetch_add(1, std::memory_order_relaxed);
+    this->write_slot = old & ~FRESH;
+    this->tail.store(seq + 1, std::memory_order_release);
+}
+
+const uint8_t *FrameRing::acquire(int64_t *timestampNs)
+{
+    while (true) {
+        const uint64_t tail = this->tail.load(std::memory_order_acquire);
+        if (this->head >= tail)
+            return nullptr;
+        // 덮어쓰인 프레임은 건너뛴다 (개수는 쓰는 쪽이 센다)
+        if (tail - this->head > uint64_t(this->depth))
+            this->head = tail - this->depth;
+
+        const uint32_t got = this->cells[this->head % this->depth].exchange(
+            this->read_slot, std::memory_order_acq_rel);
+        this->read_slot = got & ~FRESH;
+        if (!(got & FRESH)) {
+            this->head++;
+            continue;
+        }
+
+        // exchange 사이에 쓰는 쪽이 한 바퀴 돌았으면 더 새 프레임이 나온다.
+        // 순서를 지키기 위해 그보다 오래된 프레임은 나중에 나와도 버린다
+        const uint64_t seq = this->slot_seqs[this->read_slot];
+        if (seq < this->head) {
+            this->skipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        this->head = seq + 1;
+        this->consumed.fetch_add(1, std::memory_order_relaxed);
+        if (timestampNs)
+            *timestampNs = this->slot_times[this->read_slot];
+        return this->slot_data(this->read_slot);
+    }
+}
+
+FrameRingStats FrameRing::get_stats() const
+{
+    FrameRingStats stats;
+    stats.published = this->tail.load(std::memory_order_relaxed);
+    stats.consumed = this->consumed.load(std::memory_order_relaxed);
+    stats.overwritten = this->overwritten.load(std::memory_order_relaxed);
+    stats.skipped = this->skipped.load(std::memory_order_relaxed);
+    return stats;
+}
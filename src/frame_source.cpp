@@ -0,0 +1,186 @@
+#include "frame_source.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "common.hpp"
+
+bool FrameSource::is_live() const
+{
+    return false;
+}
+
+std::unique_ptr<FrameSource> FrameSource::create(const std::string &spec)
+{
+    if (spec == "synthetic")
+        return std::unique_ptr<FrameSource>(new SyntheticSource());
+    if (spec.compare(0, 5, "file:") == 0)
+        return std::unique_ptr<FrameSource>(new FileSource(spec.substr(5)));
+    if (spec == "v4l2")
+        return std::unique_ptr<FrameSource>(new V4L2Source(VIDEODEV));
+    if (spec.compare(0, 5, "v4l2:") == 0)
+        return std::unique_ptr<FrameSource>(new V4L2Source(spec.substr(5)));
+
+    fprintf(stderr, "FrameSource::create() unknown source: %s\n", spec.c_str());
+    return nullptr;
+}
+
+bool SyntheticSource::open(const int width, const int height)
+{
+    this->width = width;
+    this->height = height;
+    this->frame = 0;
+    this->buffer.assign(width * height * 3 / 2, 0);
+    return true;
+}
+
+const uint8_t *SyntheticSource::read()
+{
+    const int w = this->width;
+    const int h = this->height;
+    const auto t = int(this->frame++);
+    uint8_t *y = this->buffer.data();
+    uint8_t *u = y + w * h;
+    uint8_t *v = u + w * h / 4;
+
+    // 대각선으로 흐르는 밝기 그라데이션 위에 오른쪽으로 움직이는 흰 상자
+    const int boxSize = h / 4;
+    const int boxX = (t * 4) % (w - boxSize);
+    const int boxY = (h - boxSize) / 2;
+    for (int row = 0; row < h; row++) {
+        uint8_t *line = y + row * w;
+        for (int col = 0; col < w; col++)
+            line[col] = uint8_t(16 + (col + row + t * 2) % 220);
+        if (row >= boxY && row < boxY + boxSize)
+            memset(line + boxX, 235, boxSize);
+    }
+    for (int row = 0; row < h / 2; row++) {
+        for (int col = 0; col < w / 2; col++) {
+            u[row * (w / 2) + col] = uint8_t(128 + (col - t) % 64);
+            v[row * (w / 2) + col] = uint8_t(128 + (row + t) % 64);
+        }
+    }
+    return this->buffer.data();
+}
+
+PixelFormat SyntheticSource::get_format() const
+{
+    return PixelFormat::I420;
+}
+
+const char *SyntheticSource::get_name() const
+{
+    return "synthetic";
+}
+
+FileSource::FileSource(const std::string &path) : path(path)
+{
+    const std::string ext = ".y4m";
+    this->y4m = path.size() >= ext.size() &&
+                path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+FileSource::~FileSource()
+{
+    if (this->file)
+        fclose(this->file);
+}
+
+bool FileSource::open(const int width, const int height)
+{
+    this->file = fopen(this->path.c_str(), "rb");
+    if (this->file == nullptr) {
+        fprintf(stderr, "FileSource::open() fopen() failed: %s\n", strerror(errno));
+        return false;
+    }
+
+    if (this->y4m) {
+        if (!this->parse_y4m_header(width, height))
+            return false;
+        this->buffer.resize(width * height * 3 / 2);
+    } else {
+        this->buffer.resize(width * height * 2);
+    }
+    this->data_start = ftell(this->file);
+    return true;
+}
+
+bool FileSource::parse_y4m_header(const int width, const int height)
+{
+    char header[256]{0};
+    if (fgets(header, sizeof(header), this->file) == nullptr ||
+        strncmp(header, "YUV4MPEG2 ", 10) != 0)
+    {
+        fprintf(stderr, "FileSource::parse_y4m_header() not a Y4M file: %s\n", this->path.c_str());
+        return false;
+    }
+
+    // 공백으로 나뉜 태그: W, H, C만 확인하고 나머지(F, I, A, X)는 무시한다
+    int fileWidth = 0;
+    int fileHeight = 0;
+    const char *colorspace = "420";
+    char *save = nullptr;
+    for (char *tag = strtok_r(header + 10, " \n", &save); tag != nullptr;
+         tag = strtok_r(nullptr, " \n", &save))
+    {
+        if (tag[0] == 'W')
+            fileWidth = atoi(tag + 1);
+        else if (tag[0] == 'H')
+            fileHeight = atoi(tag + 1);
+        else if (tag[0] == 'C')
+            colorspace = tag + 1;
+    }
+    if (strncmp(colorspace, "420", 3) != 0) {
+        fprintf(stderr, "FileSource::parse_y4m_header() unsupported colorspace: C%s\n", colorspace);
+        return false;
+    }
+    if (fileWidth != width || fileHeight != height) {
+        fprintf(stderr, "FileSource::parse_y4m_header() %dx%d does not match %dx%d\n",
+                fileWidth, fileHeight, width, height);
+        return false;
+    }
+    return true;
+}
+
+bool FileSource::read_frame()
+{
+    if (this->y4m) {
+        // 프레임마다 "FRAME[ 태그]\n"가 붙는다
+        char line[256];
+        if (fgets(line, sizeof(line), this->file) == nullptr)
+            return false;
+        if (strncmp(line, "FRAME", 5) != 0) {
+            fprintf(stderr, "FileSource::read_frame() broken Y4M frame header\n");
+            return false;
+        }
+    }
+    return fread(this->buffer.data(), 1, this->buffer.size(), this->file) == this->buffer.size();
+}
+
+const uint8_t *FileSource::read()
+{
+    if (this->file == nullptr)
+        return nullptr;
+    if (this->read_frame())
+        return this->buffer.data();
+
+    // 파일 끝이면 처음부터 다시 읽는다
+    if (fseek(this->file, this->data_start, SEEK_SET) != 0 || !this->read_frame()) {
+        fprintf(stderr, "FileSource::read() no complete frame in %s\n", this->path.c_str());
+        return nullptr;
+    }
+    return this->buffer.data();
+}
+
+PixelFormat FileSource::get_format() const
+{
+    return this->y4m ? PixelFormat::I420 : PixelFormat::YUYV;
+}
+
+const char *FileSource::get_name() const
+{
+    return this->y4m ? "y4m" : "yuyv";
+}
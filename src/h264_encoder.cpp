@@ -0,0 +1,142 @@
+#include "h264_encoder.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/error.h>
+}
+
+H264Encoder::~H264Encoder()
+{
+    this->close();
+}
+
+bool H264Encoder::open(const int width, const int height,
+                       const int fps, const int64_t bitRate)
+{
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    if (!codec) {
+        fprintf(stderr, "Cannot find H.264 Codec\n");
+        return false;
+    }
+
+    this->c = avcodec_alloc_context3(codec);
+    if (!this->c) {
+        fprintf(stderr, "Failed to allocate codec context.\n");
+        return false;
+    }
+
+    this->c->bit_rate = bitRate;
+    this->c->width = width;
+    this->c->height = height;
+    this->c->time_base = {1, fps};
+    this->c->framerate = {fps, 1};
+    this->c->gop_size = 30;
+    this->c->max_b_frames = 0;
+    this->c->pix_fmt = AV_PIX_FMT_YUV420P;
+
+    if (avcodec_open2(this->c, codec, NULL) < 0) {
+        fprintf(stderr, "Failed to open codec.\n");
+        this->close();
+        return false;
+    }
+
+    this->frame = av_frame_alloc();
+    if (!this->frame) {
+        fprintf(stderr, "Failed to allocate frame.\n");
+        this->close();
+        return false;
+    }
+
+    this->frame->format = this->c->pix_fmt;
+    this->frame->width = this->c->width;
+    this->frame->height = this->c->height;
+
+    if (av_image_alloc(this->frame->data,
+                       this->frame->linesize,
+                       this->c->width,
+                       this->c->height,
+                       this->c->pix_fmt, 32) < 0)
+    {
+        fprintf(stderr, "Failed to allocate image buffer.\n");
+        av_frame_free(&this->frame);
+        this->close();
+        return false;
+    }
+
+    this->pkt = av_packet_alloc();
+    if (!this->pkt) {
+        fprintf(stderr, "Failed to allocate packet.\n");
+        this->close();
+        return false;
+    }
+
+    this->pts = 1;
+    return true;
+}
+
+void H264Encoder::close()
+{
+    av_packet_free(&this->pkt);
+    if (this->frame)
+        av_freep(&this->frame->data[0]);
+    av_frame_free(&this->frame);
+    avcodec_free_context(&this->c);
+}
+
+void H264Encoder::set_bitrate(const int64_t bitRate)
+{
+    if (this->is_open())
+        this->c->bit_rate = bitRate;
+}
+
+int64_t H264Encoder::get_bitrate() const
+{
+    return this->is_open() ? this->c->bit_rate : 0;
+}
+
+bool H264Encoder::encode(const uint8_t *const planes[3], const int strides[3],
+                         std::vector<EncodedPacketPtr> &packets)
+{
+    if (!this->is_open())
+        return false;
+
+    for (int y = 0; y < this->c->height; y++) {
+        memcpy(this->frame->data[0] + y * this->frame->linesize[0],
+               planes[0] + y * strides[0], this->c->width);
+    }
+
+    const int chroma_height = this->c->height / 2;
+    const int chroma_width = this->c->width / 2;
+    for (int y = 0; y < chroma_height; y++) {
+        memcpy(this->frame->data[1] + y * this->frame->linesize[1],
+               planes[1] + y * strides[1], chroma_width);
+        memcpy(this->frame->data[2] + y * this->frame->linesize[2],
+               planes[2] + y * strides[2], chroma_width);
+    }
+
+    this->frame->pts = this->pts++;
+    this->frame->pict_type = this->force_keyframe ? AV_PICTURE_TYPE_I
+                                                  : AV_PICTURE_TYPE_NONE;
+    this->force_keyframe = false;
+
+    if (avcodec_send_frame(this->c, this->frame) < 0) {
+        fprintf(stderr, "Failed to send frame\n");
+        return false;
+    }
+
+    while (avcodec_receive_packet(this->c, this->pkt) == 0) {
+        std::shared_ptr<EncodedPacket> packet = std::make_shared<EncodedPacket>();
+        packet->data.assign(this->pkt->data, this->pkt->data + this->pkt->size);
+        packet->pts = this->pkt->pts;
+        packet->keyframe = (this->pkt->flags & AV_PKT_FLAG_KEY) != 0;
+        packets.push_back(std::move(packet));
+        av_packet_unref(this->pkt);
+    }
+    return true;
+}
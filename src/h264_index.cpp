@@ -0,0 +1,179 @@
+#include "h264_index.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "start_code_scanner.hpp"
+#include "common.hpp"
+
+namespace {
+
+constexpr char INDEX_MAGIC[8] = {'H', '2', '6', '4', 'I', 'D', 'X', '1'};
+
+#pragma pack(1)
+struct IndexFileHeader
+{
+    char magic[8];
+    int64_t fileSize;
+    int64_t fileMtime;
+    int64_t nalCount;
+};
+#pragma pack()
+
+bool is_vcl(const uint8_t type)
+{
+    return type >= NALU_TYPE_SLICE && type <= NALU_TYPE_IDR;
+}
+
+// SEI, SPS, PPS, AUD, 14~18은 앞의 picture 다음에 오면 새 access unit을 시작한다
+bool starts_access_unit(const uint8_t type)
+{
+    return (type >= NALU_TYPE_SEI && type <= NALU_TYPE_AUD) || (type >= 14 && type <= 18);
+}
+
+// 잘리거나 깨진 인덱스로 mmap 밖을 읽지 않도록 항목마다 파일 안에 있는지 본다
+bool is_valid_index(const std::vector<NalEntry> &nals, const int64_t fileSize)
+{
+    int64_t prevEnd = 0;
+    int64_t prevFrame = 0;
+    for (const NalEntry &entry : nals) {
+        if (entry.offset < prevEnd || entry.size < entry.startCodeLen ||
+            entry.size > fileSize - entry.offset ||
+            (entry.startCodeLen != 3 && entry.startCodeLen != 4) ||
+            entry.frame < prevFrame || entry.frame > prevFrame + 1)
+            return false;
+        prevEnd = entry.offset + entry.size;
+        prevFrame = entry.frame;
+    }
+    return nals.front().frame == 0;
+}
+
+} // namespace
+
+bool H264Index::build(const uint8_t *data, const int64_t dataSize)
+{
+    this->nals.clear();
+
+    const uint8_t *end = data + dataSize;
+    const uint8_t *cur = StartCodeScanner::find(data, dataSize);
+    int32_t frame = -1;
+    bool vclSeen = false;
+    while (cur) {
+        const uint8_t startCodeLen = (cur[2] == 0x01) ? 3 : 4;
+        const uint8_t *nal = cur + startCodeLen;
+        const uint8_t *next = StartCodeScanner::find(nal, end - nal);
+        const uint8_t *nalEnd = next ? next : end;
+
+        NalEntry entry;
+        entry.offset = cur - data;
+        entry.size = nalEnd - cur;
+        entry.startCodeLen = startCodeLen;
+        entry.type = nal < nalEnd ? (nal[0] & NALU_TYPE_MASK) : 0;
+
+        bool newAccessUnit = frame < 0;
+        if (is_vcl(entry.type)) {
+            // first_mb_in_slice == 0 이면 ue(v)의 첫 비트가 1이다
+            const bool firstSlice = nal + 1 < nalEnd && (nal[1] & 0x80);
+            newAccessUnit |= vclSeen && firstSlice;
+        } else if (starts_access_unit(entry.type)) {
+            newAccessUnit |= vclSeen;
+        }
+        if (newAccessUnit) {
+            frame++;
+            vclSeen = false;
+        }
+        if (is_vcl(entry.type))
+            vclSeen = true;
+        entry.frame = frame;
+
+        this->nals.push_back(entry);
+        cur = next;
+    }
+
+    this->build_frame_table();
+    return !this->nals.empty();
+}
+
+void H264Index::build_frame_table()
+{
+    this->frame_starts.clear();
+    this->idr_frames.clear();
+    for (int64_t i = 0; i < int64_t(this->nals.size()); i++) {
+        const NalEntry &entry = this->nals[i];
+        if (entry.frame >= int64_t(this->frame_starts.size()))
+            this->frame_starts.push_back(i);
+        if (entry.type == NALU_TYPE_IDR &&
+            (this->idr_frames.empty() || this->idr_frames.back() != entry.frame))
+            this->idr_frames.push_back(entry.frame);
+    }
+}
+
+int64_t H264Index::find_idr_frame(const int64_t frame) const
+{
+    if (this->idr_frames.empty())
+        return 0;
+    auto it = std::upper_bound(this->idr_frames.begin(), this->idr_frames.end(), frame);
+    if (it == this->idr_frames.begin())
+        return this->idr_frames.front();
+    return *(it - 1);
+}
+
+bool H264Index::load(const std::string &path, const int64_t fileSize, const int64_t fileMtime)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+
+    IndexFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+              !memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) &&
+              header.fileSize == fileSize &&
+              header.fileMtime == fileMtime &&
+              header.nalCount > 0 &&
+              header.nalCount <= fileSize / 3;     // NAL마다 start code가 최소 3바이트
+    if (ok) {
+        this->nals.resize(header.nalCount);
+        ok = fread(this->nals.data(), sizeof(NalEntry), header.nalCount, f)
+             == size_t(header.nalCount) &&
+             is_valid_index(this->nals, fileSize);
+    }
+    fclose(f);
+
+    if (!ok) {
+        this->nals.clear();
+        return false;
+    }
+    this->build_frame_table();
+    return true;
+}
+
+bool H264Index::save(const std::string &path, const int64_t fileSize, const int64_t fileMtime) const
+{
+    // 다른 프로세스가 반쯤 쓴 파일을 읽지 않도록 임시 파일에 쓰고 rename 한다
+    const std::string tmpPath = path + ".tmp";
+    FILE *f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "H264Index::save() fopen(%s) failed: %s\n", tmpPath.c_str(), strerror(errno));
+        return false;
+    }
+
+    IndexFileHeader header;
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.fileSize = fileSize;
+    header.fileMtime = fileMtime;
+    header.nalCount = this->nals.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(this->nals.data(), sizeof(NalEntry), this->nals.size(), f) == this->nals.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) < 0) {
+        fprintf(stderr, "H264Index::save() failed: %s\n", strerror(errno));
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
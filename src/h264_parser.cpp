@@ -1,4 +1,5 @@
 #include "h264_parser.hpp"
+#include "start_code_scanner.hpp"
 
 #include <cassert>
 #include <cerrno>
@@ -15,7 +16,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
-H264Parser::H264Parser(const char *filename)
+H264Parser::H264Parser(const char *filename, const bool cacheIndex)
 {
     this->fd = open(filename, O_RDONLY);
     assert(this->fd >= 0);
@@ -33,6 +34,8 @@ H264Parser::H264Parser(const char *filename)
     this->ptr_mapped_file_cur=this->ptr_mapped_file_start;
     this->ptr_mapped_file_end = this->ptr_mapped_file_start + this->file_size;
     assert(this->ptr_mapped_file_cur != MAP_FAILED);
+
+    this->load_index(filename, file_stat, cacheIndex);
 }
 
 H264Parser::~H264Parser()
@@ -45,6 +48,20 @@ H264Parser::~H264Parser()
     this->ptr_mapped_file_end = nullptr;
 }
 
+void H264Parser::load_index(const std::string &filename, const struct stat &file_stat,
+                            const bool cacheIndex)
+{
+    const std::string indexPath = filename + ".idx";
+    const int64_t mtime = file_stat.st_mtime;
+    if (cacheIndex && this->index.load(indexPath, this->file_size, mtime))
+        return;
+
+    if (!this->index.build(this->ptr_mapped_file_start, this->file_size))
+        fprintf(stderr, "H264Parser::load_index() failed: no NAL unit in %s\n", filename.c_str());
+    else if (cacheIndex)
+        this->index.save(indexPath, this->file_size, mtime);
+}
+
 bool H264Parser::is_start_code(const uint8_t *_buffer,
                                const int64_t buffer_len,
                                const uint8_t start_code_type)
@@ -70,25 +87,44 @@ bool H264Parser::is_start_code(const uint8_t *_buffer,
     return false;
 }
 
-const uint8_t *H264Parser::find_next_start_code(const uint8_t *_buffer, const int64_t buffer_len)
+void H264Parser::split_nal_units(const uint8_t *data, const int64_t dataSize,
+                                 std::vector<NalUnit> &nals)
 {
-    for (int64_t i = 0; i < buffer_len - 3; i++) {
-        if (H264Parser::is_start_code(_buffer, buffer_len - i, 3) ||              
-            H264Parser::is_start_code(_buffer, buffer_len - i, 4))
-            return _buffer;
-        ++_buffer;
+    nals.clear();
+    const uint8_t *end = data + dataSize;
+    const uint8_t *cur = H264Parser::find_next_start_code(data, dataSize);
+    while (cur) {
+        const uint8_t *nal = cur + ((cur[2] == 0x01) ? 3 : 4);
+        const uint8_t *next = H264Parser::find_next_start_code(nal, end - nal);
+        const uint8_t *nalEnd = next ? next : end;
+        if (nal < nalEnd)
+            nals.push_back({nal, nalEnd - nal});
+        cur = next;
     }
-    return H264Parser::is_start_code(_buffer, 3, 3) ? _buffer : nullptr;
+}
+
+const uint8_t *H264Parser::find_next_start_code(const uint8_t *_buffer, const int64_t buffer_len)
+{
+    return StartCodeScanner::find(_buffer, buffer_len);
 }
 
 std::pair<const uint8_t *, int64_t> H264Parser::get_next_frame()
 {
-    auto remain_bytes = this->ptr_mapped_file_end - this->ptr_mapped_file_cur;
-    if (remain_bytes == 0)
+    int64_t offset = this->ptr_mapped_file_cur - this->ptr_mapped_file_start;
+    auto frame = this->get_next_frame(offset);
+    this->ptr_mapped_file_cur = this->ptr_mapped_file_start + offset;
+    return frame;
+}
+
+std::pair<const uint8_t *, int64_t> H264Parser::get_next_frame(int64_t &offset) const
+{
+    const uint8_t *ptr_cur = this->ptr_mapped_file_start + offset;
+    auto remain_bytes = this->ptr_mapped_file_end - ptr_cur;
+    if (remain_bytes <= 0)
         return {nullptr, 0};
 
-    if (!H264Parser::is_start_code(this->ptr_mapped_file_cur, remain_bytes, 4) && 
-        !H264Parser::is_start_code(this->ptr_mapped_file_cur, remain_bytes, 3))
+    if (!H264Parser::is_start_code(ptr_cur, remain_bytes, 4) && 
+        !H264Parser::is_start_code(ptr_cur, remain_bytes, 3))
     {
         fprintf(stderr,
                 "H264Parser::get_one_frame() failed:" 
@@ -96,11 +132,32 @@ std::pair<const uint8_t *, int64_t> H264Parser::get_next_frame()
         return {nullptr, -1};
     }
 
-    const uint8_t *ptr_next_start_code = H264Parser::find_next_start_code(this->ptr_mapped_file_cur + 3, remain_bytes - 3);
+    const uint8_t *ptr_next_start_code = H264Parser::find_next_start_code(ptr_cur + 3, remain_bytes - 3);
     if (!ptr_next_start_code)
         return {nullptr, 0};
-    const int64_t frame_size = ptr_next_start_code - this->ptr_mapped_file_cur;
-    auto ptr_ret = this->ptr_mapped_file_cur;
-    this->ptr_mapped_file_cur += frame_size;
-    return {ptr_ret, frame_size};
+    const int64_t frame_size = ptr_next_start_code - ptr_cur;
+    offset += frame_size;
+    return {ptr_cur, frame_size};
+}
+
+std::pair<const uint8_t *, int64_t> H264Parser::get_nal(const int64_t nalIndex) const
+{
+    if (nalIndex < 0 || nalIndex >= this->index.get_nal_count())
+        return {nullptr, 0};
+    const NalEntry &entry = this->index.get_nal(nalIndex);
+    return {this->ptr_mapped_file_start + entry.offset, entry.size};
+}
+
+std::pair<const uint8_t *, int64_t> H264Parser::get_frame(const int64_t frame) const
+{
+    if (frame < 0 || frame >= this->index.get_frame_count())
+        return {nullptr, 0};
+    const int64_t firstNal = this->index.get_frame_start(frame);
+    const int64_t lastNal = (frame + 1 < this->index.get_frame_count())
+                            ? this->index.get_frame_start(frame + 1) - 1
+                            : this->index.get_nal_count() - 1;
+    const NalEntry &first = this->index.get_nal(firstNal);
+    const NalEntry &last = this->index.get_nal(lastNal);
+    return {this->ptr_mapped_file_start + first.offset,
+            last.offset + last.size - first.offset};
 }
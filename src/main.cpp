@@ -1,13 +1,134 @@
 #include <rtsp_cam.hpp>
 #include <rtsp.hpp>
 
-#include <iostream>
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
 #include <thread>
 
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options] [cam [source] [fps]]\n"
+            "       %s [options] file <h264 file>\n"
+            "  source: v4l2[:device] (default), synthetic, file:<path.y4m | raw YUYV path>\n"
+            "  fps:    capture rate for synthetic/file sources, 0 = as fast as possible\n"
+            "options:\n"
+            "  --pacing <slices>  send each frame in this many slices over the frame interval\n"
+            "                     (0 = by packet count (default), 1 = one burst)\n"
+            "  --txtime           let the kernel pace packets with SO_TXTIME (needs fq qdisc)\n"
+            "  --multicast <group>[:port]\n"
+            "                     multicast group for udp_multicast clients (default %s:%d)\n"
+            "  --ttl <hops>       multicast TTL, 1-255 (default %d = local network only)\n",
+            prog, prog, MULTICAST_DEFAULT_GROUP, MULTICAST_DEFAULT_PORT, MULTICAST_DEFAULT_TTL);
+}
+
+struct SendOptions
+{
+    int pacing = 0;
+    bool txtime = false;
+    std::string multicast_group = MULTICAST_DEFAULT_GROUP;
+    long multicast_port = MULTICAST_DEFAULT_PORT;
+    long multicast_ttl = MULTICAST_DEFAULT_TTL;
+};
+
+// 숫자만 있고 [min, max] 안이면 true
+static bool parse_long(const char *text, const long min, const long max, long &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    value = strtol(text, &end, 10);
+    return end != text && *end == '\0' && errno == 0 && value >= min && value <= max;
+}
+
+// <group>[:port]. RTCP가 port + 1을 쓰므로 port는 65534까지다
+static bool parse_multicast(const char *text, SendOptions &options)
+{
+    const char *colon = strchr(text, ':');
+    if (!colon) {
+        options.multicast_group = text;
+        return true;
+    }
+    options.multicast_group.assign(text, colon - text);
+    return parse_long(colon + 1, 1, 65534, options.multicast_port);
+}
+
+// 앞쪽의 --옵션을 읽고 나머지 인자를 앞으로 당긴다. 모르는 옵션이면 false
+static bool parse_options(int &argc, char *argv[], SendOptions &options)
+{
+    int pos = 1;
+    while (pos < argc && !strncmp(argv[pos], "--", 2)) {
+        if (!strcmp(argv[pos], "--pacing") && pos + 1 < argc) {
+            options.pacing = atoi(argv[pos + 1]);
+            pos += 2;
+        } else if (!strcmp(argv[pos], "--txtime")) {
+            options.txtime = true;
+            pos++;
+        } else if (!strcmp(argv[pos], "--multicast") && pos + 1 < argc) {
+            if (!parse_multicast(argv[pos + 1], options))
+                return false;
+            pos += 2;
+        } else if (!strcmp(argv[pos], "--ttl") && pos + 1 < argc) {
+            if (!parse_long(argv[pos + 1], 1, 255, options.multicast_ttl))
+                return false;
+            pos += 2;
+        } else {
+            return false;
+        }
+    }
+    for (int i = pos; i < argc; i++)
+        argv[i - pos + 1] = argv[i];
+    argc -= pos - 1;
+    return true;
+}
+
+static bool apply_options(RtspServer &server, const SendOptions &options)
+{
+    server.set_pacing(options.pacing);
+    server.set_txtime(options.txtime);
+    return server.set_multicast(options.multicast_group.c_str(),
+                                uint16_t(options.multicast_port), int(options.multicast_ttl));
+}
+
 int main(int argc, char *argv[])
 {
-    RTSPCam rtspServer;
+    SendOptions options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *mode = argc > 1 ? argv[1] : "cam";
+
+    if (!strcmp(mode, "file")) {
+        if (argc < 3) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        RTSP rtspServer(argv[2]);
+        if (!apply_options(rtspServer, options))
+            return EXIT_FAILURE;
+        rtspServer.Start(20001102, "h264_streaming", 600, 30);
+        return 0;
+    }
+    if (strcmp(mode, "cam") != 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto source = FrameSource::create(argc > 2 ? argv[2] : "v4l2");
+    if (!source) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    RTSPCam rtspServer(std::move(source));
+    if (argc > 3)
+        rtspServer.set_capture_fps(atof(argv[3]));
+    if (!apply_options(rtspServer, options))
+        return EXIT_FAILURE;
+
     std::thread capture_thread([&rtspServer]() {
          rtspServer.capture_frames();
      });
@@ -16,8 +137,5 @@ int main(int argc, char *argv[])
     
      capture_thread.join();
 
-    // RTSP rtspServer(argv[2]);
-    //rtspServer.Start(20001102, "h264_streaming", 600, 30);
-
     return 0;
 }
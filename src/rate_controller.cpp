@@ -0,0 +1,89 @@
+#include "rate_controller.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+// 혼잡: 이 중 하나라도 넘으면 줄인다
+constexpr double CONGESTED_LOSS = 0.10;
+constexpr double CONGESTED_JITTER_MS = 50;
+constexpr int64_t CONGESTED_QUEUE_BYTES = 128 * 1024;
+// 여유: 모두 이 아래여야 올린다. 둘 사이에서는 그대로 둔다
+constexpr double GOOD_LOSS = 0.02;
+constexpr double GOOD_JITTER_MS = 20;
+constexpr int64_t GOOD_QUEUE_BYTES = 16 * 1024;
+
+constexpr double DECREASE_FACTOR = 0.85;
+constexpr double INCREASE_FACTOR = 1.08;
+constexpr int INCREASE_AFTER_GOOD_SAMPLES = 3;
+constexpr int MAX_FRAME_DIVISOR = 4;
+// 줄인 직후의 보고는 아직 이전 bitrate의 결과이므로 잠시 기다린다
+constexpr int64_t DECREASE_HOLD_NS = 2000LL * 1000 * 1000;
+constexpr int64_t INCREASE_HOLD_NS = 5000LL * 1000 * 1000;
+
+} // namespace
+
+RateController::RateController(const int64_t minBitRate, const int64_t maxBitRate,
+                               const int64_t startBitRate)
+    : min_bitrate(minBitRate), max_bitrate(std::max(minBitRate, maxBitRate))
+{
+    this->bitrate = std::max(this->min_bitrate, std::min(startBitRate, this->max_bitrate));
+}
+
+bool RateController::update(const RateSample &sample, const int64_t nowNs)
+{
+    // RR은 몇 초에 한 번 오므로 RR이 없는 주기는 손실/지터로 좋다고도 나쁘다고도 보지 않는다
+    const bool congested = (sample.has_report && (sample.fraction_lost > CONGESTED_LOSS ||
+                                                  sample.jitter_ms > CONGESTED_JITTER_MS)) ||
+                           sample.queue_bytes > CONGESTED_QUEUE_BYTES ||
+                           sample.dropped_frames > 0;
+    const bool queueGood = sample.queue_bytes < GOOD_QUEUE_BYTES;
+    const bool good = sample.has_report &&
+                      sample.fraction_lost < GOOD_LOSS &&
+                      sample.jitter_ms < GOOD_JITTER_MS &&
+                      queueGood;
+
+    if (congested) {
+        this->good_samples = 0;
+        if (this->last_decrease && nowNs - this->last_decrease < DECREASE_HOLD_NS)
+            return false;
+        this->last_decrease = nowNs;
+
+        // 손실이 클수록 더 줄인다
+        const double factor = std::min(DECREASE_FACTOR, 1 - sample.fraction_lost / 2);
+        const auto target = std::max(this->min_bitrate, int64_t(this->bitrate * factor));
+        if (target < this->bitrate) {
+            this->bitrate = target;
+            return true;
+        }
+        if (this->frame_divisor < MAX_FRAME_DIVISOR) {
+            this->frame_divisor *= 2;
+            return true;
+        }
+        return false;
+    }
+
+    if (!good) {
+        if (sample.has_report || !queueGood)
+            this->good_samples = 0;
+        return false;
+    }
+    if (++this->good_samples < INCREASE_AFTER_GOOD_SAMPLES)
+        return false;
+    if (this->last_decrease && nowNs - this->last_decrease < INCREASE_HOLD_NS)
+        return false;
+    this->good_samples = 0;
+
+    // 줄일 때와 반대로 frame 간격부터 되돌린다
+    if (this->frame_divisor > 1) {
+        this->frame_divisor /= 2;
+        return true;
+    }
+    const auto target = std::min(this->max_bitrate, int64_t(this->bitrate * INCREASE_FACTOR));
+    if (target > this->bitrate) {
+        this->bitrate = target;
+        return true;
+    }
+    return false;
+}
@@ -3,6 +3,7 @@
 
 #include "request_handler.hpp"
 #include "common.hpp"
+#include "utils.hpp"
 
 void RequestHandler::replyCmd_OPTIONS(char *buffer, 
                                       const int64_t bufferLen,
@@ -11,7 +12,7 @@ void RequestHandler::replyCmd_OPTIONS(char *buffer,
     snprintf(buffer, bufferLen,
              "RTSP/1.0 200 OK\r\n"
              "CSeq: %d\r\n"
-             "Public: OPTIONS, DESCRIBE, SETUP, PLAY\r\n\r\n",
+             "Public: OPTIONS, DESCRIBE, SETUP, PLAY, GET_PARAMETER, TEARDOWN\r\n\r\n",
              cseq);
 }
 
@@ -32,18 +33,53 @@ void RequestHandler::replyCmd_SETUP(char *buffer,
              SERVER_RTP_PORT, SERVER_RTCP_PORT, ssrcNum, sessionID, timeout);
 }
 
+void RequestHandler::replyCmd_SETUP_INTERLEAVED(char *buffer,
+                                                const int64_t bufferLen,
+                                                const int cseq,
+                                                const int rtpChannel,
+                                                const int ssrcNum,
+                                                const char *sessionID,
+                                                const int timeout)
+{
+    snprintf(buffer, bufferLen,
+             "RTSP/1.0 200 OK\r\n"
+             "CSeq: %d\r\n"
+             "Transport: RTP/AVP/TCP;unicast;interleaved=%d-%d;ssrc=%d;mode=play\r\n"
+             "Session: %s; timeout=%d\r\n\r\n",
+             cseq, rtpChannel, rtpChannel + 1, ssrcNum, sessionID, timeout);
+}
+
+void RequestHandler::replyCmd_SETUP_MULTICAST(char *buffer,
+                                              const int64_t bufferLen,
+                                              const int cseq,
+                                              const char *group,
+                                              const int port,
+                                              const int ttl,
+                                              const int ssrcNum,
+                                              const char *sessionID,
+                                              const int timeout)
+{
+    snprintf(buffer, bufferLen,
+             "RTSP/1.0 200 OK\r\n"
+             "CSeq: %d\r\n"
+             "Transport: RTP/AVP;multicast;destination=%s;port=%d-%d;ttl=%d;ssrc=%d;mode=play\r\n"
+             "Session: %s; timeout=%d\r\n\r\n",
+             cseq, group, port, port + 1, ttl, ssrcNum, sessionID, timeout);
+}
+
 void RequestHandler::replyCmd_PLAY(char *buffer,
                                    const int64_t bufferLen,
                                    const int cseq,
                                    const char *sessionID,
-                                   const int timeout)
+                                   const int timeout,
+                                   const double rangeStart)
 {
     snprintf(buffer, bufferLen,
              "RTSP/1.0 200 OK\r\n"
              "CSeq: %d\r\n"
-             "Range: npt=0.000-\r\n"
+             "Range: npt=%.3f-\r\n"
              "Session: %s; timeout=%d\r\n\r\n",
-             cseq, sessionID, timeout);
+             cseq, rangeStart, sessionID, timeout);
 }
 
 void RequestHandler::replyCmd_HEARTBEAT(char *buffer,
@@ -62,21 +98,18 @@ void RequestHandler::replyCmd_HEARTBEAT(char *buffer,
 void RequestHandler::replyCmd_DESCRIBE(char *buffer,
                                        const int64_t bufferLen,
                                        const int cseq,
-                                       const char *url)
+                                       const char *url,
+                                       const char *sdpMedia)
 {
     char ip[100]{0};
-    char sdp[500]{0};
+    char sdp[RTSP_SEND_BUF_SIZE]{0};
 
-    sscanf(url, "rtsp://%[^:]:", ip);
+    sscanf(url, "rtsp://%99[^:/]", ip);
     snprintf(sdp, sizeof(sdp),
              "v=0\r\n"
              "o=- 9%ld 1 IN IP4 %s\r\n"
-             "t=0 0\r\n"
-             "a=control:*\r\n"
-             "m=video 0 RTP/AVP 96\r\n"
-             "a=rtpmap:96 H264/90000\r\n"
-             "a=control:track0\r\n",
-             time(nullptr), ip);
+             "%s",
+             time(nullptr), ip, sdpMedia);
 
     snprintf(buffer, bufferLen,
              "RTSP/1.0 200 OK\r\n"
@@ -85,4 +118,89 @@ void RequestHandler::replyCmd_DESCRIBE(char *buffer,
              "Content-type: application/sdp\r\n"
              "Content-length: %ld\r\n\r\n%s",
              cseq, url, strlen(sdp), sdp);
+}
+
+int64_t RequestHandler::build_SDP_media(char *buffer,
+                                       const int64_t bufferLen,
+                                       const uint8_t *sps,
+                                       const int64_t spsLen,
+                                       const uint8_t *pps,
+                                       const int64_t ppsLen)
+{
+    // RFC 6184 8.1: profile-level-id는 SPS의 profile_idc, constraint flags, level_idc
+    char fmtp[RTSP_SEND_BUF_SIZE / 2]{0};
+    int64_t fmtpLen = snprintf(fmtp, sizeof(fmtp), "packetization-mode=1");
+    if (sps && spsLen >= 4 && pps && ppsLen > 0) {
+        char spsBase64[RTSP_SEND_BUF_SIZE / 4];
+        char ppsBase64[RTSP_SEND_BUF_SIZE / 8];
+        if (Utils::Base64Encode(sps, spsLen, spsBase64, sizeof(spsBase64)) < 0 ||
+            Utils::Base64Encode(pps, ppsLen, ppsBase64, sizeof(ppsBase64)) < 0)
+        {
+            fprintf(stderr, "RequestHandler::build_SDP_media() parameter sets too large\n");
+            return -1;
+        }
+        fmtpLen = snprintf(fmtp, sizeof(fmtp),
+                           "packetization-mode=1;profile-level-id=%02x%02x%02x;"
+                           "sprop-parameter-sets=%s,%s",
+                           sps[1], sps[2], sps[3], spsBase64, ppsBase64);
+        if (fmtpLen >= int64_t(sizeof(fmtp)))
+            return -1;
+    }
+
+    const int64_t len = snprintf(buffer, bufferLen,
+                                 "t=0 0\r\n"
+                                 "a=control:*\r\n"
+                                 "m=video 0 RTP/AVP 96 97\r\n"
+                                 "a=rtpmap:96 H264/90000\r\n"
+                                 "a=fmtp:96 %s\r\n"
+                                 "a=rtcp-fb:96 nack\r\n"
+                                 "a=rtpmap:97 rtx/90000\r\n"
+                                 "a=fmtp:97 apt=96\r\n"
+                                 "a=control:track0\r\n",
+                                 fmtp);
+    return (len < bufferLen) ? len : -1;
+}
+
+void RequestHandler::replyCmd_GET_PARAMETER(char *buffer,
+                                            const int64_t bufferLen,
+                                            const int cseq,
+                                            const char *sessionID)
+{
+    // SETUP 전에 보낸 keepalive에는 세션이 없다
+    if (sessionID[0] == 0) {
+        snprintf(buffer, bufferLen,
+                 "RTSP/1.0 200 OK\r\n"
+                 "CSeq: %d\r\n\r\n",
+                 cseq);
+        return;
+    }
+    snprintf(buffer, bufferLen,
+             "RTSP/1.0 200 OK\r\n"
+             "CSeq: %d\r\n"
+             "Session: %s\r\n\r\n",
+             cseq, sessionID);
+}
+
+void RequestHandler::replyCmd_TEARDOWN(char *buffer,
+                                       const int64_t bufferLen,
+                                       const int cseq,
+                                       const char *sessionID)
+{
+    snprintf(buffer, bufferLen,
+             "RTSP/1.0 200 OK\r\n"
+             "CSeq: %d\r\n"
+             "Session: %s\r\n\r\n",
+             cseq, sessionID);
+}
+
+void RequestHandler::replyCmd_ERROR(char *buffer,
+                                    const int64_t bufferLen,
+                                    const int cseq,
+                                    const int statusCode,
+                                    const char *reason)
+{
+    snprintf(buffer, bufferLen,
+             "RTSP/1.0 %d %s\r\n"
+             "CSeq: %d\r\n\r\n",
+             statusCode, reason, cseq);
 }
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "rtcp.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+#include <arpa/inet.h>
+
+namespace {
+
+constexpr int64_t RTCP_HEADER_SIZE = 4;
+constexpr int64_t RTCP_SENDER_INFO_SIZE = 20;
+constexpr int64_t RTCP_REPORT_BLOCK_SIZE = 24;
+// 보낸 쪽 SSRC, 미디어 SSRC
+constexpr int64_t RTCP_FB_HEADER_SIZE = 8;
+constexpr int64_t RTCP_NACK_FCI_SIZE = 4;
+constexpr uint8_t RTCP_VERSION = 2;
+constexpr uint8_t SDES_CNAME = 1;
+// 1900-01-01부터 1970-01-01까지의 초
+constexpr uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+
+void write_u16(uint8_t *p, const uint16_t v)
+{
+    const uint16_t n = htons(v);
+    memcpy(p, &n, sizeof(n));
+}
+
+void write_u32(uint8_t *p, const uint32_t v)
+{
+    const uint32_t n = htonl(v);
+    memcpy(p, &n, sizeof(n));
+}
+
+uint16_t read_u16(const uint8_t *p)
+{
+    uint16_t n;
+    memcpy(&n, p, sizeof(n));
+    return ntohs(n);
+}
+
+uint32_t read_u32(const uint8_t *p)
+{
+    uint32_t n;
+    memcpy(&n, p, sizeof(n));
+    return ntohl(n);
+}
+
+// count는 RC/SC, length는 헤더를 뺀 32비트 워드 수
+void write_header(uint8_t *p, const uint8_t count, const uint8_t pt, const int64_t len)
+{
+    p[0] = (RTCP_VERSION << 6) | (count & 0x1f);
+    p[1] = pt;
+    write_u16(p + 2, uint16_t(len / 4 - 1));
+}
+
+} // namespace
+
+void RtcpStats::print(const char *name) const
+{
+    fprintf(stdout,
+            "[%s] reports: %ld, fraction lost: %.2f%%, cumulative lost: %ld, "
+            "highest seq: %u, jitter: %.2f ms, rtt: %.2f ms\n",
+            name, this->reports, this->fraction_lost * 100, this->cumulative_lost,
+            this->highest_seq, this->jitter_ms, this->rtt_ms);
+}
+
+uint64_t Rtcp::ntp_now()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    const uint64_t seconds = uint64_t(ts.tv_sec) + NTP_UNIX_OFFSET;
+    const uint64_t fraction = (uint64_t(ts.tv_nsec) << 32) / 1000000000ULL;
+    return (seconds << 32) | fraction;
+}
+
+int64_t Rtcp::build_sender_report(uint8_t *buffer, const int64_t bufferLen,
+                                  const uint32_t ssrc, const uint64_t ntp,
+                                  const uint32_t rtpTimestamp, const uint32_t packetCount,
+                                  const uint32_t octetCount, const char *cname)
+{
+    const int64_t cnameLen = std::min<int64_t>(strlen(cname), 255);
+    const int64_t srLen = RTCP_HEADER_SIZE + 4 + RTCP_SENDER_INFO_SIZE;
+    // SSRC, CNAME 항목(type, length, text), END, 4바이트 정렬
+    const int64_t sdesLen = (RTCP_HEADER_SIZE + 4 + 2 + cnameLen + 1 + 3) / 4 * 4;
+    if (srLen + sdesLen > bufferLen)
+        return -1;
+    memset(buffer, 0, srLen + sdesLen);
+
+    uint8_t *sr = buffer;
+    write_header(sr, 0, RTCP_PT_SR, srLen);
+    write_u32(sr + 4, ssrc);
+    write_u32(sr + 8, uint32_t(ntp >> 32));
+    write_u32(sr + 12, uint32_t(ntp));
+    write_u32(sr + 16, rtpTimestamp);
+    write_u32(sr + 20, packetCount);
+    write_u32(sr + 24, octetCount);
+
+    uint8_t *sdes = buffer + srLen;
+    write_header(sdes, 1, RTCP_PT_SDES, sdesLen);
+    write_u32(sdes + 4, ssrc);
+    sdes[8] = SDES_CNAME;
+    sdes[9] = uint8_t(cnameLen);
+    memcpy(sdes + 10, cname, cnameLen);
+    return srLen + sdesLen;
+}
+
+bool Rtcp::parse_report_blocks(const uint8_t *data, const int64_t dataLen,
+                               std::vector<RtcpReportBlock> &blocks)
+{
+    blocks.clear();
+    int64_t pos = 0;
+    while (pos + RTCP_HEADER_SIZE <= dataLen) {
+        const uint8_t *p = data + pos;
+        if ((p[0] >> 6) != RTCP_VERSION)
+            return false;
+        const int64_t count = p[0] & 0x1f;
+        const uint8_t pt = p[1];
+        const int64_t len = (int64_t((p[2] << 8) | p[3]) + 1) * 4;
+        if (pos + len > dataLen)
+            return false;
+
+        if (pt == RTCP_PT_SR || pt == RTCP_PT_RR) {
+            int64_t blockPos = RTCP_HEADER_SIZE + 4;
+            if (pt == RTCP_PT_SR)
+                blockPos += RTCP_SENDER_INFO_SIZE;
+            if (blockPos + count * RTCP_REPORT_BLOCK_SIZE > len)
+                return false;
+            for (int64_t i = 0; i < count; i++, blockPos += RTCP_REPORT_BLOCK_SIZE) {
+                const uint8_t *b = p + blockPos;
+                RtcpReportBlock block;
+                block.ssrc = read_u32(b);
+                block.fractionLost = b[4];
+                // 24비트 부호 있는 정수
+                int32_t lost = (b[5] << 16) | (b[6] << 8) | b[7];
+                if (lost & 0x800000)
+                    lost -= 0x1000000;
+                block.cumulativeLost = lost;
+                block.highestSeq = read_u32(b + 8);
+                block.jitter = read_u32(b + 12);
+                block.lsr = read_u32(b + 16);
+                block.dlsr = read_u32(b + 20);
+                blocks.push_back(block);
+            }
+        }
+        pos += len;
+    }
+    return pos == dataLen;
+}
+
+int64_t Rtcp::parse_nacks(const uint8_t *data, const int64_t dataLen, const uint32_t mediaSsrc,
+                          std::vector<uint16_t> &seqs)
+{
+    seqs.clear();
+    int64_t nacks = 0;
+    int64_t pos = 0;
+    while (pos + RTCP_HEADER_SIZE <= dataLen) {
+        const uint8_t *p = data + pos;
+        if ((p[0] >> 6) != RTCP_VERSION)
+            return -1;
+        const uint8_t fmt = p[0] & 0x1f;
+        const uint8_t pt = p[1];
+        const int64_t len = (int64_t((p[2] << 8) | p[3]) + 1) * 4;
+        if (pos + len > dataLen)
+            return -1;
+
+        if (pt == RTCP_PT_RTPFB && fmt == RTCP_FMT_NACK) {
+            if (len < RTCP_HEADER_SIZE + RTCP_FB_HEADER_SIZE)
+                return -1;
+            if (read_u32(p + 8) == mediaSsrc) {
+                nacks++;
+                // FCI: PID와 그 뒤 16개 패킷의 손실 여부(BLP)
+                for (int64_t fci = RTCP_HEADER_SIZE + RTCP_FB_HEADER_SIZE;
+                     fci + RTCP_NACK_FCI_SIZE <= len; fci += RTCP_NACK_FCI_SIZE)
+                {
+                    const uint16_t pid = read_u16(p + fci);
+                    const uint16_t blp = read_u16(p + fci + 2);
+                    seqs.push_back(pid);
+                    for (int bit = 0; bit < 16; bit++) {
+                        if (blp & (1 << bit))
+                            seqs.push_back(uint16_t(pid + bit + 1));
+                    }
+                }
+            }
+        }
+        pos += len;
+    }
+    return pos == dataLen ? nacks : -1;
+}
+
+void Rtcp::update_stats(RtcpStats &stats, const RtcpReportBlock &block,
+                        const uint64_t arrivalNtp, const uint32_t clockRate)
+{
+    stats.reports++;
+    stats.fraction_lost = block.fractionLost / 256.0;
+    stats.cumulative_lost = block.cumulativeLost;
+    stats.highest_seq = block.highestSeq;
+    stats.jitter_ms = double(block.jitter) * 1000 / clockRate;
+
+    // RTT = A - LSR - DLSR, 모두 NTP 가운데 32비트(1/65536초 단위)
+    if (block.lsr) {
+        const uint32_t arrival = uint32_t(arrivalNtp >> 16);
+        const uint32_t rtt = arrival - block.lsr - block.dlsr;
+        if (int32_t(rtt) >= 0)
+            stats.rtt_ms = rtt * 1000.0 / 65536;
+    }
+}
@@ -23,19 +23,17 @@ int64_t RtpPacket::rtp_sendto(int sockfd,                   const int64_t _buffe
                               const uint32_t timeStampStep)
 {
     auto sentBytes = sendto(sockfd, this, _bufferLen, flags, to, sizeof(sockaddr));
-    this->set_header_seq(this->get_header_seq() + 1);
-    this->set_header_timestamp(this->get_header_timestamp() + timeStampStep);
+    this->advance(timeStampStep);
     return sentBytes;
 }
 
-inline void RtpPacket::set_header_seq(const uint32_t _seq)
+void RtpPacket::advance(const uint32_t timeStampStep)
 {
-    this->header.set_seq(_seq);
-    this->cached_cur_seq = _seq;
+    this->set_header_seq(this->get_header_seq() + 1);
+    this->set_header_timestamp(this->get_header_timestamp() + timeStampStep);
 }
 
-inline void RtpPacket::set_header_timestamp(const uint32_t _newtimestamp)
+void RtpPacket::next_seq()
 {
-    this->header.set_timestamp(_newtimestamp);
-    this->cached_cur_timestamp = _newtimestamp;
+    this->set_header_seq(this->get_header_seq() + 1);
 }
\ No newline at end of file
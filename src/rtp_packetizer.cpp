@@ -0,0 +1,139 @@
+#include "rtp_packetizer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+void PacketizerStats::print(const char *name) const
+{
+    fprintf(stdout,
+            "[%s] nals: %ld, packets: %ld, STAP-A: %ld packets carrying %ld nals "
+            "(%ld packets saved)\n",
+            name, this->nals, this->packets, this->stap_packets, this->stap_nals,
+            this->stap_nals - this->stap_packets);
+}
+
+RtpPacketizer::RtpPacketizer(const int64_t mtu)
+{
+    this->set_mtu(mtu);
+}
+
+void RtpPacketizer::set_mtu(const int64_t mtu)
+{
+    // RtpPacket 버퍼보다 큰 페이로드는 만들 수 없다
+    const int64_t maxMtu = MAX_RTP_DATA_SIZE + IP_V4_HEADER_SIZE
+                           + UDP_HEADER_SIZE + RTP_HEADER_SIZE;
+    this->mtu = std::max(MIN_PATH_MTU, std::min(mtu, maxMtu));
+    this->max_payload_size = this->mtu - IP_V4_HEADER_SIZE
+                             - UDP_HEADER_SIZE - RTP_HEADER_SIZE;
+}
+
+int64_t RtpPacketizer::packetize(RtpPacket &rtpPack, const uint8_t *nal,
+                                 const int64_t nalSize, const Sink &sink,
+                                 const bool marker) const
+{
+    if (nalSize <= 0)
+        return 0;
+
+    // Single NAL unit packet
+    if (nalSize <= this->max_payload_size) {
+        rtpPack.set_header_marker(marker);
+        return sink(rtpPack, RTP_HEADER_SIZE, nal, nalSize);
+    }
+
+    // FU-A: NAL 헤더는 FU indicator/header로 옮기고 나머지를 MTU 단위로 나눈다
+    const uint8_t naluHeader = nal[0];
+    const int64_t fragmentSize = this->max_payload_size - FU_SIZE;
+    auto payload = rtpPack.get_payload();
+    int64_t pos = 1;
+    int64_t sentBytes = 0;
+    while (pos < nalSize) {
+        const int64_t size = std::min(fragmentSize, nalSize - pos);
+        payload[0] = (naluHeader & NALU_F_NRI_MASK) | SET_FU_A_MASK;
+        payload[1] = naluHeader & NALU_TYPE_MASK;
+        if (pos == 1)
+            payload[1] |= FU_S_MASK;
+        if (pos + size == nalSize)
+            payload[1] |= FU_E_MASK;
+        rtpPack.set_header_marker(marker && pos + size == nalSize);
+
+        auto ret = sink(rtpPack, RTP_HEADER_SIZE + FU_SIZE, nal + pos, size);
+        if (ret < 0)
+            return -1;
+        sentBytes += ret;
+        pos += size;
+    }
+    return sentBytes;
+}
+
+int64_t RtpPacketizer::packetize_access_unit(RtpPacket &rtpPack, const std::vector<NalUnit> &nals,
+                                             const Sink &sink, PacketizerStats *stats) const
+{
+    const int64_t nalNum = nals.size();
+    int64_t sentBytes = 0;
+    int64_t i = 0;
+    while (i < nalNum) {
+        // 이어지는 작은 NAL을 한 패킷에 들어가는 만큼 모은다
+        int64_t count = 0;
+        int64_t stapLen = STAP_A_HEADER_SIZE;
+        while (this->aggregation && i + count < nalNum &&
+               stapLen + STAP_A_NALU_SIZE_LEN + nals[i + count].size <= this->max_payload_size)
+        {
+            stapLen += STAP_A_NALU_SIZE_LEN + nals[i + count].size;
+            count++;
+        }
+
+        int64_t ret;
+        int64_t packets = 1;
+        if (count >= 2) {
+            ret = this->aggregate(rtpPack, &nals[i], count, sink, i + count == nalNum);
+            if (stats) {
+                stats->stap_packets++;
+                stats->stap_nals += count;
+            }
+        } else {
+            count = 1;
+            const NalUnit &nal = nals[i];
+            ret = this->packetize(rtpPack, nal.data, nal.size, sink, i + 1 == nalNum);
+            if (nal.size > this->max_payload_size) {
+                const int64_t fragmentSize = this->max_payload_size - FU_SIZE;
+                packets = (nal.size - 1 + fragmentSize - 1) / fragmentSize;
+            }
+        }
+        if (ret < 0)
+            return -1;
+        if (stats) {
+            stats->nals += count;
+            stats->packets += packets;
+        }
+        sentBytes += ret;
+        i += count;
+    }
+    return sentBytes;
+}
+
+int64_t RtpPacketizer::aggregate(RtpPacket &rtpPack, const NalUnit *nals, const int64_t count,
+                                 const Sink &sink, const bool marker) const
+{
+    // STAP-A 헤더의 F는 하나라도 세워져 있으면, NRI는 가장 큰 값을 쓴다
+    uint8_t forbidden = 0;
+    uint8_t nri = 0;
+    for (int64_t i = 0; i < count; i++) {
+        forbidden |= nals[i].data[0] & NALU_F_MASK;
+        nri = std::max<uint8_t>(nri, nals[i].data[0] & NALU_NRI_MASK);
+    }
+
+    auto payload = rtpPack.get_payload();
+    payload[0] = forbidden | nri | SET_STAP_A_MASK;
+    int64_t pos = STAP_A_HEADER_SIZE;
+    for (int64_t i = 0; i < count; i++) {
+        payload[pos] = uint8_t(nals[i].size >> 8);
+        payload[pos + 1] = uint8_t(nals[i].size);
+        memcpy(payload + pos + STAP_A_NALU_SIZE_LEN, nals[i].data, nals[i].size);
+        pos += STAP_A_NALU_SIZE_LEN + nals[i].size;
+    }
+
+    rtpPack.set_header_marker(marker);
+    return sink(rtpPack, RTP_HEADER_SIZE + pos, nullptr, 0);
+}
@@ -0,0 +1,373 @@
+#include "rtp_sender.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <linux/net_tstamp.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "common.hpp"
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+#ifndef SO_TXTIME
+#define SO_TXTIME 61
+#define SCM_TXTIME SO_TXTIME
+#endif
+
+// 한 번의 sendmmsg()로 보낼 수 있는 최대 메시지 수
+constexpr int64_t MAX_SENDMMSG_BATCH = 1024;
+// 한 번의 sendmsg()에 넘길 수 있는 최대 iovec 수 (IOV_MAX)
+constexpr int64_t MAX_IOV_BATCH = 1024;
+// '$', channel, 16비트 길이
+constexpr int64_t INTERLEAVED_PREFIX_SIZE = 4;
+// 커널의 UDP_MAX_SEGMENTS, 그리고 UDP 데이터그램 하나의 최대 크기
+constexpr int64_t MAX_GSO_SEGMENTS = 64;
+constexpr int64_t MAX_GSO_BYTES = MAX_UDP_PACKET_SIZE - IP_V4_HEADER_SIZE - UDP_HEADER_SIZE;
+
+double RtpSendStats::syscalls_per_frame() const
+{
+    return this->frames ? double(this->syscalls) / this->frames : 0;
+}
+
+void RtpSendStats::print(const char *name) const
+{
+    fprintf(stdout,
+            "[%s] frames: %ld, packets: %ld, bytes: %ld, syscalls: %ld "
+            "(%.2f syscalls/frame), errors: %ld, dropped frames: %ld\n",
+            name, this->frames, this->packets, this->bytes, this->syscalls,
+            this->syscalls_per_frame(), this->errors, this->dropped_frames);
+}
+
+RtpSender::RtpSender(const SendMode mode) : mode(mode)
+{
+}
+
+void RtpSender::set_mode(const SendMode mode)
+{
+    this->mode = mode;
+}
+
+void RtpSender::push(const uint8_t *head, const int64_t headLen,
+                     const uint8_t *payload, const int64_t payloadLen)
+{
+    RtpPacketRef packet;
+    packet.headOffset = this->head_buffer.size();
+    packet.headLen = headLen;
+    packet.payload = payload;
+    packet.payloadLen = payloadLen;
+    this->packets.push_back(packet);
+    this->head_buffer.insert(this->head_buffer.end(), head, head + headLen);
+}
+
+void RtpSender::hold(std::shared_ptr<const void> owner)
+{
+    if (owner)
+        this->owners.push_back(std::move(owner));
+}
+
+void RtpSender::set_txtime(const int64_t startNs, const int64_t spanNs)
+{
+    this->txtime_start = startNs;
+    this->txtime_span = spanNs;
+}
+
+void RtpSender::clear()
+{
+    this->head_buffer.clear();
+    this->packets.clear();
+    this->owners.clear();
+    this->sent_packets = 0;
+    this->txtime_start = 0;
+    this->txtime_span = 0;
+}
+
+bool RtpSender::enable_txtime(const int sockfd)
+{
+    sock_txtime config{};
+    config.clockid = CLOCK_MONOTONIC;
+    config.flags = 0;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TXTIME, &config, sizeof(config)) < 0) {
+        fprintf(stderr, "RtpSender::enable_txtime() setsockopt(SO_TXTIME) failed: %s\n",
+                strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int64_t RtpSender::flush(int sockfd, const sockaddr_in &to, RtpSendStats &stats)
+{
+    return this->flush_until(sockfd, to, stats, this->packets.size());
+}
+
+int64_t RtpSender::flush_until(int sockfd, const sockaddr_in &to, RtpSendStats &stats,
+                               const int64_t count)
+{
+    const int64_t first = this->sent_packets;
+    const int64_t last = std::min<int64_t>(count, this->packets.size());
+    if (first >= last)
+        return 0;
+
+    int64_t sentBytes;
+    if (this->txtime_span > 0)
+        sentBytes = this->flush_sendmmsg(sockfd, to, stats, first, last);
+    else if (this->mode == SendMode::GSO && this->gso_available)
+        sentBytes = this->flush_gso(sockfd, to, stats, first, last);
+    else if (this->mode == SendMode::SENDTO)
+        sentBytes = this->flush_sendto(sockfd, to, stats, first, last);
+    else
+        sentBytes = this->flush_sendmmsg(sockfd, to, stats, first, last);
+
+    // 실패한 프레임은 나머지를 버린다
+    this->sent_packets = last;
+    if (sentBytes < 0 || last == int64_t(this->packets.size())) {
+        stats.frames++;
+        this->clear();
+    }
+    return sentBytes;
+}
+
+int64_t RtpSender::flush_interleaved(int sockfd, const uint8_t channel,
+                                     std::vector<uint8_t> &backlog, RtpSendStats &stats)
+{
+    const int64_t first = this->sent_packets;
+    const int64_t last = this->packets.size();
+    if (first >= last)
+        return 0;
+
+    this->prefixes.resize((last - first) * INTERLEAVED_PREFIX_SIZE);
+    this->iovecs.resize((last - first) * 3);
+    int64_t iovLen = 0;
+    int64_t frameBytes = 0;
+    for (int64_t i = first; i < last; i++) {
+        const int64_t len = this->packet_len(i);
+        uint8_t *prefix = &this->prefixes[(i - first) * INTERLEAVED_PREFIX_SIZE];
+        prefix[0] = '$';
+        prefix[1] = channel;
+        prefix[2] = uint8_t(len >> 8);
+        prefix[3] = uint8_t(len);
+        this->iovecs[iovLen].iov_base = prefix;
+        this->iovecs[iovLen].iov_len = INTERLEAVED_PREFIX_SIZE;
+        iovLen++;
+        iovLen += this->fill_iovecs(i, &this->iovecs[iovLen]);
+        frameBytes += INTERLEAVED_PREFIX_SIZE + len;
+    }
+
+    // 앞에 밀린 데이터가 있으면 순서를 지키기 위해 소켓에 바로 쓰지 않는다
+    int64_t sentBytes = 0;
+    int64_t pos = 0;
+    while (backlog.empty() && pos < iovLen) {
+        msghdr msg{};
+        msg.msg_iov = &this->iovecs[pos];
+        msg.msg_iovlen = std::min(iovLen - pos, MAX_IOV_BATCH);
+        auto ret = sendmsg(sockfd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        stats.syscalls++;
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            fprintf(stderr, "RtpSender::flush_interleaved() failed: %s\n", strerror(errno));
+            stats.errors++;
+            stats.frames++;
+            this->clear();
+            return -1;
+        }
+        sentBytes += ret;
+        while (ret > 0) {
+            iovec &iov = this->iovecs[pos];
+            if (ret < int64_t(iov.iov_len)) {
+                iov.iov_base = static_cast<uint8_t *>(iov.iov_base) + ret;
+                iov.iov_len -= ret;
+                break;
+            }
+            ret -= iov.iov_len;
+            pos++;
+        }
+    }
+    for (; pos < iovLen; pos++) {
+        const uint8_t *base = static_cast<const uint8_t *>(this->iovecs[pos].iov_base);
+        backlog.insert(backlog.end(), base, base + this->iovecs[pos].iov_len);
+    }
+
+    stats.packets += last - first;
+    stats.bytes += frameBytes;
+    stats.frames++;
+    this->clear();
+    return sentBytes;
+}
+
+int64_t RtpSender::packet_len(const int64_t index) const
+{
+    return this->packets[index].headLen + this->packets[index].payloadLen;
+}
+
+int64_t RtpSender::fill_iovecs(const int64_t index, iovec *iov) const
+{
+    const RtpPacketRef &packet = this->packets[index];
+    iov[0].iov_base = const_cast<uint8_t *>(this->head_buffer.data() + packet.headOffset);
+    iov[0].iov_len = packet.headLen;
+    if (packet.payloadLen == 0)
+        return 1;
+    iov[1].iov_base = const_cast<uint8_t *>(packet.payload);
+    iov[1].iov_len = packet.payloadLen;
+    return 2;
+}
+
+int64_t RtpSender::flush_sendto(int sockfd, const sockaddr_in &to, RtpSendStats &stats,
+                                const int64_t first, const int64_t last)
+{
+    int64_t sentBytes = 0;
+    for (int64_t i = first; i < last; i++) {
+        iovec iov[2];
+        msghdr msg{};
+        msg.msg_name = const_cast<sockaddr_in *>(&to);
+        msg.msg_namelen = sizeof(to);
+        msg.msg_iov = iov;
+        msg.msg_iovlen = this->fill_iovecs(i, iov);
+
+        auto ret = sendmsg(sockfd, &msg, 0);
+        stats.syscalls++;
+        if (ret < 0) {
+            fprintf(stderr, "RtpSender::flush_sendto() failed: %s\n", strerror(errno));
+            stats.errors++;
+            return -1;
+        }
+        stats.packets++;
+        stats.bytes += ret;
+        sentBytes += ret;
+    }
+    return sentBytes;
+}
+
+int64_t RtpSender::flush_sendmmsg(int sockfd, const sockaddr_in &to, RtpSendStats &stats,
+                                  const int64_t first, const int64_t last)
+{
+    const int64_t packetNum = this->packets.size();
+    constexpr int64_t controlSize = CMSG_SPACE(sizeof(uint64_t));
+    this->iovecs.resize(packetNum * 2);
+    this->msgs.resize(packetNum);
+    if (this->txtime_span > 0)
+        this->controls.assign(packetNum * controlSize, 0);
+    for (int64_t i = first; i < last; i++) {
+        memset(&this->msgs[i], 0, sizeof(mmsghdr));
+        this->msgs[i].msg_hdr.msg_name = const_cast<sockaddr_in *>(&to);
+        this->msgs[i].msg_hdr.msg_namelen = sizeof(to);
+        this->msgs[i].msg_hdr.msg_iov = &this->iovecs[i * 2];
+        this->msgs[i].msg_hdr.msg_iovlen = this->fill_iovecs(i, &this->iovecs[i * 2]);
+        if (this->txtime_span <= 0)
+            continue;
+
+        // 프레임 안의 패킷을 송신 시각으로 고르게 벌려 놓으면 fq qdisc가 그 시각에 내보낸다
+        msghdr &hdr = this->msgs[i].msg_hdr;
+        hdr.msg_control = &this->controls[i * controlSize];
+        hdr.msg_controllen = controlSize;
+        cmsghdr *cm = CMSG_FIRSTHDR(&hdr);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_TXTIME;
+        cm->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+        const uint64_t txtime = this->txtime_start + this->txtime_span * i / packetNum;
+        memcpy(CMSG_DATA(cm), &txtime, sizeof(txtime));
+    }
+
+    int64_t sentBytes = 0;
+    int64_t pos = first;
+    while (pos < last) {
+        const int64_t batch = std::min(last - pos, MAX_SENDMMSG_BATCH);
+        int ret = sendmmsg(sockfd, &this->msgs[pos], batch, 0);
+        stats.syscalls++;
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "RtpSender::flush_sendmmsg() failed: %s\n", strerror(errno));
+            stats.errors++;
+            return -1;
+        }
+        if (ret == 0)
+            break;
+        for (int i = 0; i < ret; i++) {
+            stats.packets++;
+            stats.bytes += this->msgs[pos + i].msg_len;
+            sentBytes += this->msgs[pos + i].msg_len;
+        }
+        pos += ret;
+    }
+    return sentBytes;
+}
+
+int64_t RtpSender::flush_gso(int sockfd, const sockaddr_in &to, RtpSendStats &stats,
+                             const int64_t first, const int64_t last)
+{
+    this->iovecs.resize(MAX_GSO_SEGMENTS * 2);
+    int64_t sentBytes = 0;
+    int64_t pos = first;
+    while (pos < last) {
+        // 같은 크기의 패킷이 이어지는 구간을 하나의 메시지로 보낸다. 마지막 패킷만 작아도 된다
+        const int64_t segmentSize = this->packet_len(pos);
+        const int64_t maxSegments = std::min(MAX_GSO_SEGMENTS, MAX_GSO_BYTES / segmentSize);
+        int64_t count = 1;
+        while (pos + count < last && count < maxSegments) {
+            const int64_t len = this->packet_len(pos + count);
+            if (len > segmentSize)
+                break;
+            count++;
+            if (len < segmentSize)
+                break;
+        }
+
+        // 커널이 iovec들을 이어 붙인 뒤 gso_size 단위로 자른다
+        int64_t iovLen = 0;
+        for (int64_t i = 0; i < count; i++)
+            iovLen += this->fill_iovecs(pos + i, &this->iovecs[iovLen]);
+
+        char control[CMSG_SPACE(sizeof(uint16_t))]{0};
+        msghdr msg{};
+        msg.msg_name = const_cast<sockaddr_in *>(&to);
+        msg.msg_namelen = sizeof(to);
+        msg.msg_iov = this->iovecs.data();
+        msg.msg_iovlen = iovLen;
+        if (count > 1) {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t gsoSize = segmentSize;
+            memcpy(CMSG_DATA(cm), &gsoSize, sizeof(gsoSize));
+        }
+
+        auto ret = sendmsg(sockfd, &msg, 0);
+        stats.syscalls++;
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (count > 1 && (errno == EINVAL || errno == ENOPROTOOPT ||
+                              errno == EOPNOTSUPP || errno == EIO))
+            {
+                // 커널이나 NIC가 UDP GSO를 지원하지 않으면 sendmmsg로 되돌아간다
+                fprintf(stderr, "RtpSender::flush_gso() UDP_SEGMENT rejected (%s), "
+                        "falling back to sendmmsg\n", strerror(errno));
+                this->gso_available = false;
+                auto rest = this->flush_sendmmsg(sockfd, to, stats, pos, last);
+                return rest < 0 ? -1 : sentBytes + rest;
+            }
+            fprintf(stderr, "RtpSender::flush_gso() failed: %s\n", strerror(errno));
+            stats.errors++;
+            return -1;
+        }
+        stats.packets += count;
+        stats.bytes += ret;
+        sentBytes += ret;
+        pos += count;
+    }
+    return sentBytes;
+}
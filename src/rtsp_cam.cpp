@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdint>
@@ -8,533 +9,463 @@
 #include <thread>
 
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
-#include <sys/mman.h>
-#include <linux/videodev2.h>
-
-extern "C" {
-#include <libavcodec/avcodec.h>
-#include <libavutil/imgutils.h>
-#include <libavutil/error.h>
-#include <libswscale/swscale.h>
-}
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include "rtsp_cam.hpp"
+#include "frame_pacer.hpp"
+#include "yuyv_converter.hpp"
 #include "rtp_packet.hpp"
 #include "common.hpp"
 #include "request_handler.hpp"
 #include "utils.hpp"
 
-Buffer *buffers = nullptr;
-unsigned int n_buffers = 0;
 YUV420Buffer yuv420_buffer;
 
-RTSPCam::RTSPCam()
+RTSPCam::RTSPCam(std::unique_ptr<FrameSource> source) : source(std::move(source))
 {
+    this->frame_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    this->packet_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this->frame_event_fd < 0 || this->packet_event_fd < 0) {
+        fprintf(stderr, "RTSPCam::RTSPCam() eventfd() failed: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
 }
 
 RTSPCam::~RTSPCam()
 {
-	close(this->server_rtcp_sock_fd);
-	close(this->server_rtp_sock_fd);
-	close(this->server_rtsp_sock_fd);
+    // 인코딩 스레드를 깨워서 끝내고, 녹화 스레드는 남은 패킷을 다 쓰고 끝낸다
+    this->running = false;
+    const uint64_t one = 1;
+    if (write(this->frame_event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        perror("eventfd write");
+    if (this->encode_thread.joinable())
+        this->encode_thread.join();
+    this->record_queue.close();
+    if (this->record_thread.joinable())
+        this->record_thread.join();
+
+    this->frame_ring.get_stats().print("frame ring");
+    this->encode_stats.print("encode");
+    this->send_stats.print("send");
+    this->recorder.close();
+    this->record_stats.print("record");
+    this->recorder.get_stats().print("recorder");
+    if (this->gop_burst_timer_fd >= 0)
+        this->loop.remove_timer(this->gop_burst_timer_fd);
+    close(this->packet_event_fd);
+    close(this->frame_event_fd);
 }
 
-void RTSPCam::init_device(int fd)
+void RTSPCam::set_capture_fps(const double fps)
 {
-    v4l2_format fmt;
-    memset(&fmt, 0, sizeof(fmt));
+    this->capture_fps = fps;
+}
 
-    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    fmt.fmt.pix.width = WIDTH;
-    fmt.fmt.pix.height = HEIGHT;
-    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
-    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+void RTSPCam::capture_frames()
+{
+    if (!this->source || !this->source->open(WIDTH, HEIGHT)) {
+        fprintf(stderr, "RTSPCam::capture_frames() failed to open frame source\n");
+        return;
+    }
+    const bool paced = !this->source->is_live() && this->capture_fps > 0;
+    fprintf(stdout, "capture from %s (%s), YUYV conversion: %s\n", this->source->get_name(),
+            paced ? "paced" : (this->source->is_live() ? "device rate" : "as fast as possible"),
+            YuyvConverter::impl_name(YuyvConverter::get_impl()));
+
+    // 장치가 없는 소스는 절대 시각에 맞춰 읽어서 간격 오차가 쌓이지 않게 한다
+    FramePacer pacer(paced ? this->capture_fps : 30);
+    pacer.start(EventLoop::now_ns());
+
+    while (this->running) {
+        if (paced) {
+            const int64_t deadline = pacer.get_deadline();
+            const timespec ts{time_t(deadline / 1000000000), long(deadline % 1000000000)};
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+            }
+            pacer.tick(EventLoop::now_ns());
+        }
 
-    Utils::xioctl(fd, VIDIOC_S_FMT, &fmt);
+        const uint8_t *captured = this->source->read();
+        if (captured == nullptr)
+            break;
 
-    if (fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_YUYV) {
-        std::cerr << "Unsupported format." << std::endl;
-        exit(EXIT_FAILURE);
-    }
+        // ring의 빈 슬롯에 바로 변환하고 인덱스만 넘긴다
+        const int64_t convertStart = EventLoop::now_ns();
+        uint8_t *dst = this->frame_ring.get_write_buffer();
+        if (this->source->get_format() == PixelFormat::I420) {
+            memcpy(dst, captured, this->frame_ring.get_frame_size());
+        } else {
+            const YuyvConverter::Planes planes{dst, dst + WIDTH * HEIGHT,
+                                               dst + WIDTH * HEIGHT * 5 / 4, WIDTH, WIDTH / 2};
+            YuyvConverter::convert(captured, WIDTH * 2, planes, WIDTH, HEIGHT);
+        }
+        const int64_t convertEnd = EventLoop::now_ns();
+        this->frame_ring.publish(convertEnd);
 
-    if (fmt.fmt.pix.width != WIDTH || fmt.fmt.pix.height != HEIGHT) {
-        std::cerr << "Unsupported resolution." << std::endl;
-        exit(EXIT_FAILURE);
-    }
+        const uint64_t one = 1;
+        if (write(this->frame_event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+            perror("eventfd write");  // 대기 중인 인코딩 스레드를 깨움
 
-    std::cout << "Device Initialization Complete: "
-              << WIDTH << "x" << HEIGHT
-              << " YUYV" << std::endl;
+        this->convert_stats.add(0, convertEnd - convertStart, 0);
+        if (this->convert_stats.items % STAGE_REPORT_ITEMS == 0)
+            this->convert_stats.print("convert");
+    }
+    // convert_stats는 캡처 스레드만 쓰므로 끝나는 통계도 여기서 출력한다
+    this->convert_stats.print("convert");
 }
 
-void RTSPCam::init_mmap(int fd)
+void RTSPCam::Start(const int ssrcNum, const char *sessionID,
+                    const int timeout, const float fps)
 {
-    v4l2_requestbuffers req;
-    memset(&req, 0, sizeof(req));
+    this->init(ssrcNum, sessionID, timeout, fps);
+
+    this->loop.add(this->packet_event_fd, EPOLLIN, [this](uint32_t) {
+        this->on_packets_ready();
+    });
+    this->loop.add_timer(RATE_CONTROL_INTERVAL_MS * 1000 * 1000, [this]() {
+        this->update_rate();
+    });
+    this->gop_burst_timer_fd = this->loop.add_deadline_timer([this]() {
+        return this->send_gop_burst();
+    });
+    this->encode_thread = std::thread([this]() { this->encode_loop(); });
+    this->record_thread = std::thread([this]() { this->record_loop(); });
+    this->loop.run();
+}
 
-    req.count = 6;
-    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    req.memory = V4L2_MEMORY_MMAP;
+void RTSPCam::on_play(RtspSession &session)
+{
+    // 인코더는 인코딩 스레드가 연다. 다른 시청자가 없었으면 캐시한 GOP는 오래된 것이다
+    const bool live = this->viewers.load() > 0;
+    this->update_viewers(nullptr);
+    if (!live || this->gop_cache.empty() || this->gop_burst_timer_fd < 0) {
+        this->keyframe_requested = true;
+        printf("H.264 encoding & streaming started\n");
+        return;
+    }
 
-    Utils::xioctl(fd, VIDIOC_REQBUFS, &req);
+    // 마지막 IDR부터 빠르게 보내고, 그동안 나온 프레임은 뒤에 이어 붙여 live로 따라잡는다
+    std::deque<EncodedItem> &burst = this->gop_bursts[session.fd];
+    burst.assign(this->gop_cache.begin(), this->gop_cache.end());
+    printf("GOP cache: sending %zu frames (%ld bytes) to new viewer\n",
+           burst.size(), this->gop_cache_bytes);
+    this->loop.set_deadline(this->gop_burst_timer_fd, EventLoop::now_ns());
+}
 
-    if (req.count < 2) {
-        std::cerr << "At least 2 buffers required for memory mapping." << std::endl;
-        exit(EXIT_FAILURE);
-    }
+void RTSPCam::on_keyframe_needed(RtspSession & /*session*/)
+{
+    this->keyframe_requested = true;
+}
 
-    buffers = new Buffer[req.count];
+void RTSPCam::on_close(RtspSession &session)
+{
+    this->gop_bursts.erase(session.fd);
+    this->update_viewers(&session);
+}
 
-    for (n_buffers = 0; n_buffers < req.count; ++n_buffers) {
-        v4l2_buffer buf;
-        memset(&buf, 0, sizeof(buf));
+void RTSPCam::update_viewers(const RtspSession *closing)
+{
+    int count = 0;
+    for (auto &it : this->sessions) {
+        if (it.second.get() != closing && it.second->state == SessionState::PLAYING)
+            count++;
+    }
+    this->viewers = count;
+    // 시청자가 없으면 인코딩을 멈추므로 캐시가 오래된다
+    if (count == 0) {
+        this->gop_cache.clear();
+        this->gop_cache_bytes = 0;
+    }
+}
 
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = n_buffers;
+void RTSPCam::on_receiver_report(RtspSession &session)
+{
+    const RtcpStats &stats = session.rtcpStats;
+    this->rate_sample.has_report = true;
+    this->rate_sample.fraction_lost = std::max(this->rate_sample.fraction_lost, stats.fraction_lost);
+    this->rate_sample.jitter_ms = std::max(this->rate_sample.jitter_ms, stats.jitter_ms);
+}
 
-        Utils::xioctl(fd, VIDIOC_QUERYBUF, &buf);
+void RTSPCam::update_rate()
+{
+    // 송신 큐와 버린 프레임은 지금 상태를 본다
+    int64_t droppedTotal = 0;
+    for (auto &it : this->sessions) {
+        const RtspSession &session = *it.second;
+        if (session.state != SessionState::PLAYING)
+            continue;
+        this->rate_sample.queue_bytes = std::max<int64_t>(this->rate_sample.queue_bytes,
+                                                          session.get_send_backlog());
+        droppedTotal += session.sendStats.dropped_frames;
+    }
+    this->rate_sample.dropped_frames = std::max<int64_t>(0, droppedTotal - this->dropped_frames_total);
+    this->dropped_frames_total = droppedTotal;
 
-        buffers[n_buffers].length = buf.length;
-        buffers[n_buffers].start = mmap(nullptr, buf.length,
-                                        PROT_READ | PROT_WRITE, MAP_SHARED,
-                                        fd, buf.m.offset);
+    const int64_t oldBitRate = this->rate_controller.get_bitrate();
+    if (this->viewers.load() &&
+        this->rate_controller.update(this->rate_sample, EventLoop::now_ns()))
+    {
+        // 인코딩 스레드가 다음 프레임에 적용한다
+        this->target_bitrate = this->rate_controller.get_bitrate();
+        this->frame_divisor = this->rate_controller.get_frame_divisor();
+        fprintf(stdout,
+                "rate control: %ld -> %ld bps, 1/%d frames (loss %.1f%%, jitter %.1f ms, "
+                "queue %ld bytes, dropped %ld)\n",
+                oldBitRate, this->rate_controller.get_bitrate(),
+                this->rate_controller.get_frame_divisor(),
+                this->rate_sample.fraction_lost * 100, this->rate_sample.jitter_ms,
+                this->rate_sample.queue_bytes, this->rate_sample.dropped_frames);
+    }
+    this->rate_sample = RateSample();
+}
 
-        if (buffers[n_buffers].start == MAP_FAILED) {
-            perror("mmap");
-            exit(EXIT_FAILURE);
+void RTSPCam::encode_loop()
+{
+    pollfd pfd{this->frame_event_fd, POLLIN, 0};
+    while (this->running) {
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "RTSPCam::encode_loop() poll() failed: %s\n", strerror(errno));
+            return;
+        }
+        uint64_t count = 0;
+        if (read(this->frame_event_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+            fprintf(stderr, "RTSPCam::encode_loop() read() failed: %s\n", strerror(errno));
+
+        // 다음 acquire()까지 슬롯을 빌려 쓰므로 복사하지 않고 인코딩한다
+        int64_t depth = this->frame_ring.get_pending();
+        int64_t captureNs = 0;
+        const uint8_t *capframe;
+        while (this->running && (capframe = this->frame_ring.acquire(&captureNs)) != nullptr) {
+            this->encode_frame(capframe, captureNs, depth);
+            depth = this->frame_ring.get_pending();
         }
     }
-    std::cout << "Memory Mapping Complete." << std::endl;
 }
 
-void RTSPCam::capture_frames() {
-    int camfd = open(VIDEODEV, O_RDWR | O_NONBLOCK, 0);
-    if (camfd == -1) {
-        perror("Failed to open video device");
+void RTSPCam::encode_frame(const uint8_t *capframe, const int64_t captureNs, const int64_t depth)
+{
+    // 시청자가 없으면 인코더를 닫아 두고, 다음 PLAY에서 다시 열어 IDR부터 시작한다
+    if (!this->viewers.load()) {
+        if (this->encoder.is_open()) {
+            this->encoder.close();
+            printf("H.264 encoder closed: no viewers\n");
+        }
         return;
     }
-    init_device(camfd);
-    init_mmap(camfd);
-
-    for (unsigned int i = 0; i < n_buffers; ++i) {
-        v4l2_buffer buf;
-        memset(&buf, 0, sizeof(buf));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = i;
-
-        Utils::xioctl(camfd, VIDIOC_QBUF, &buf);
+    if (this->encoder_failed)
+        return;
+    if (!this->encoder.is_open()) {
+        if (!this->encoder.open(WIDTH, HEIGHT, int(this->fps), this->target_bitrate.load())) {
+            this->encoder_failed = true;
+            return;
+        }
+        this->encoder.request_keyframe();
+        this->captured_frames = 0;
     }
+    // 혼잡이 심하면 frame rate도 낮춘다
+    const int frameDivisor = this->frame_divisor.load();
+    if (this->captured_frames++ % frameDivisor)
+        return;
 
-    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    Utils::xioctl(camfd, VIDIOC_STREAMON, &type);
+    const int64_t start = EventLoop::now_ns();
+    if (this->keyframe_requested.exchange(false))
+        this->encoder.request_keyframe();
+    const int64_t bitRate = this->target_bitrate.load();
+    if (bitRate != this->encoder.get_bitrate())
+        this->encoder.set_bitrate(bitRate);
 
-    std::cout << "Streaming started" << std::endl;
+    const uint8_t *planes[3] = {capframe,
+                                capframe + WIDTH * HEIGHT,
+                                capframe + WIDTH * HEIGHT * 5 / 4};
+    const int strides[3] = {WIDTH, WIDTH / 2, WIDTH / 2};
 
-    SwsContext *img_convert_ctx = sws_getContext(
-        WIDTH, HEIGHT, AV_PIX_FMT_YUYV422,
-        WIDTH, HEIGHT, AV_PIX_FMT_YUV420P,
-        SWS_BICUBIC, nullptr, nullptr, nullptr
-    );
-    
-    if (!img_convert_ctx) {
-        std::cerr << "Failed to initialize sws_getContext" << std::endl;
-        close(camfd);
+    std::vector<EncodedPacketPtr> packets;
+    if (!this->encoder.encode(planes, strides, packets))
         return;
+
+    const int64_t end = EventLoop::now_ns();
+    const auto timeStampStep = uint32_t(90000 / this->fps) * frameDivisor;
+    bool queued = false;
+    for (const auto &pkt : packets) {
+        EncodedItem item;
+        item.packet = pkt;
+        item.timeStampStep = timeStampStep;
+        item.capture_ns = captureNs;
+        item.enqueued_ns = end;
+        queued |= this->hand_over(this->send_queue, this->send_wait_idr, item);
+        if (this->recording.load())
+            this->hand_over(this->record_queue, this->record_wait_idr, item);
+    }
+    if (queued) {
+        const uint64_t one = 1;
+        if (write(this->packet_event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+            perror("eventfd write");
     }
 
-    AVFrame *pFrameIn = av_frame_alloc();
-    if (!pFrameIn) {
-        std::cerr << "Failed to allocate input frame" << std::endl;
-        sws_freeContext(img_convert_ctx);
-        close(camfd);
-        return;
+    this->encode_stats.add(start - captureNs, end - start, depth);
+    if (this->encode_stats.items % STAGE_REPORT_ITEMS == 0)
+        this->encode_stats.print("encode");
+}
+
+bool RTSPCam::hand_over(BoundedQueue<EncodedItem> &queue, bool &waitIdr, const EncodedItem &item)
+{
+    // 한 번 버리면 참조가 끊기므로 다음 IDR부터 다시 넘긴다
+    if (waitIdr && !item.packet->keyframe) {
+        this->encode_stats.dropped++;
+        return false;
+    }
+    if (!queue.try_push(item)) {
+        this->encode_stats.dropped++;
+        waitIdr = true;
+        this->encoder.request_keyframe();
+        return false;
     }
+    waitIdr = false;
+    return true;
+}
 
-    pFrameIn->format = AV_PIX_FMT_YUYV422;
-    pFrameIn->width = WIDTH;
-    pFrameIn->height = HEIGHT;
-    av_frame_get_buffer(pFrameIn, 1);
-
-    AVFrame *pFrameOut = av_frame_alloc();
-    if (!pFrameOut) {
-        std::cerr << "Failed to allocate output frame" << std::endl;
-        av_frame_free(&pFrameIn);
-        sws_freeContext(img_convert_ctx);
-        close(camfd);
+void RTSPCam::on_packets_ready()
+{
+    uint64_t count = 0;
+    if (read(this->packet_event_fd, &count, sizeof(count)) != sizeof(count))
         return;
-    }
 
-    pFrameOut->format = AV_PIX_FMT_YUV420P;
-    pFrameOut->width = WIDTH;
-    pFrameOut->height = HEIGHT;
-    av_frame_get_buffer(pFrameOut, 1);
-
-    while (true) {
-        v4l2_buffer buf;
-        memset(&buf, 0, sizeof(buf));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-
-        Utils::xioctl(camfd, VIDIOC_DQBUF, &buf);
-
-        av_image_fill_arrays(pFrameIn->data, pFrameIn->linesize,
-                             static_cast<uint8_t *>(buffers[buf.index].start), 
-                             AV_PIX_FMT_YUYV422, WIDTH, HEIGHT, 1);
-
-        sws_scale(img_convert_ctx, 
-                  (const uint8_t * const *)pFrameIn->data, pFrameIn->linesize,
-                  0, HEIGHT, pFrameOut->data, pFrameOut->linesize);
-
-        YUV420Frame frame;
-        frame.y_data.assign(pFrameOut->data[0], pFrameOut->data[0] + WIDTH * HEIGHT);
-        frame.u_data.assign(pFrameOut->data[1], pFrameOut->data[1] + WIDTH * HEIGHT / 4);
-        frame.v_data.assign(pFrameOut->data[2], pFrameOut->data[2] + WIDTH * HEIGHT / 4);
-
-        // 프레임을 큐에 추가
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex);
-			if (frame_queue.size() >= 4){
-				frame_queue.pop();
-			}
-            frame_queue.push(frame);
+    EncodedItem item;
+    int64_t depth = 0;
+    bool pushed = false;
+    while (this->send_queue.try_pop(item, &depth)) {
+        const int64_t start = EventLoop::now_ns();
+        // 한 번 인코딩한 패킷을 재생 중인 모든 세션이 패킷화한다
+        const EncodedPacketPtr &pkt = item.packet;
+        if (pkt->keyframe)
+            this->update_parameter_sets(*pkt);
+        this->cache_gop(item);
+        for (auto &it : this->sessions) {
+            RtspSession &session = *it.second;
+            if (session.state != SessionState::PLAYING)
+                continue;
+            // 캐시한 GOP를 아직 보내는 중이면 그 뒤에 이어 붙인다
+            auto burst = this->gop_bursts.find(session.fd);
+            if (burst != this->gop_bursts.end()) {
+                burst->second.push_back(item);
+                continue;
+            }
+            this->push_item(session, item);
+            pushed = true;
         }
-        queue_cond.notify_one(); // 대기 중인 컨슈머를 깨움
-
-        Utils::xioctl(camfd, VIDIOC_QBUF, &buf);
+        this->send_stats.add(start - item.enqueued_ns, EventLoop::now_ns() - start, depth);
+        if (this->send_stats.items % STAGE_REPORT_ITEMS == 0)
+            this->send_stats.print("send");
     }
-
-    av_frame_free(&pFrameIn);
-    av_frame_free(&pFrameOut);
-    sws_freeContext(img_convert_ctx);
-    close(camfd);
+    if (pushed)
+        this->flush_streams(EventLoop::now_ns());
 }
 
-void RTSPCam::Start(const int ssrcNum, const char *sessionID,
-                    const int timeout, const float fps)
+void RTSPCam::push_item(RtspSession &session, const EncodedItem &item)
 {
-    this->server_rtsp_sock_fd = Utils::Socket(AF_INET, SOCK_STREAM);
-    if (!Utils::Bind(this->server_rtsp_sock_fd, "0.0.0.0", SERVER_RTSP_PORT)) {
-        fprintf(stderr, "failed to create RTSP socket: %s\n", strerror(errno));
-        exit(EXIT_FAILURE);
+    // 큐가 차거나 링을 덮어써서 버린 프레임만큼 timestamp도 건너뛰도록 캡처 시각 차이로 정한다
+    RtpPacket &rtpPack = *session.rtpPack;
+    if (session.capture_base_ns == 0) {
+        session.capture_base_ns = item.capture_ns;
+        session.rtp_base_timestamp = rtpPack.get_header_timestamp();
     }
-    Utils::Listen(this->server_rtsp_sock_fd);
-    
+    const int64_t elapsedUs = (item.capture_ns - session.capture_base_ns) / 1000;
+    rtpPack.set_header_timestamp(session.rtp_base_timestamp +
+                                 uint32_t(elapsedUs * (RTP_H264_CLOCK_RATE / 1000) / 1000));
+    this->push_stream(session, item.packet->data.data(), item.packet->data.size(),
+                      item.timeStampStep, item.packet);
+}
 
-    this->server_rtp_sock_fd = Utils::Socket(AF_INET, SOCK_DGRAM);
-    if (!Utils::Bind(this->server_rtp_sock_fd, "0.0.0.0", SERVER_RTP_PORT)) {
-        fprintf(stderr, "failed to create RTP socket: %s\n", strerror(errno));
-        exit(EXIT_FAILURE);
+void RTSPCam::update_parameter_sets(const EncodedPacket &pkt)
+{
+    // 인코더가 IDR마다 붙이는 SPS/PPS로 SDP를 만든다. 같으면 다시 만들지 않는다
+    H264Parser::split_nal_units(pkt.data.data(), pkt.data.size(), this->nal_units);
+    const NalUnit *sps = nullptr;
+    const NalUnit *pps = nullptr;
+    for (const NalUnit &nal : this->nal_units) {
+        const uint8_t type = nal.data[0] & NALU_TYPE_MASK;
+        if (type == NALU_TYPE_SPS && !sps)
+            sps = &nal;
+        else if (type == NALU_TYPE_PPS && !pps)
+            pps = &nal;
     }
+    if (sps && pps)
+        this->set_parameter_sets(sps->data, sps->size, pps->data, pps->size);
+}
 
-    this->server_rtcp_sock_fd = Utils::Socket(AF_INET, SOCK_DGRAM);
-    if (!Utils::Bind(this->server_rtcp_sock_fd, "0.0.0.0", SERVER_RTCP_PORT)) {
-        fprintf(stderr, "failed to create RTCP socket: %s\n", strerror(errno));
-        exit(EXIT_FAILURE);
+void RTSPCam::cache_gop(const EncodedItem &item)
+{
+    const EncodedPacket &pkt = *item.packet;
+    if (pkt.keyframe) {
+        this->gop_cache.clear();
+        this->gop_cache_bytes = 0;
+    } else if (this->gop_cache.empty()) {
+        return;     // IDR 없이는 디코딩할 수 없다
     }
-
-    fprintf(stdout, "rtsp://127.0.0.1:%d\n", SERVER_RTSP_PORT);
-
-    //while (true) {
-    sockaddr_in cliAddr{};
-    memset(&cliAddr, 0, sizeof(cliAddr));
-    socklen_t addrLen = sizeof(cliAddr);
-    auto cli_sockfd = accept(this->server_rtsp_sock_fd,
-                             reinterpret_cast<sockaddr *>(&cliAddr),
-                             &addrLen);
-    if (cli_sockfd < 0) {
-        fprintf(stderr, "accept error(): %s\n", strerror(errno));
-        //continue;
+    if (this->gop_cache_bytes + int64_t(pkt.data.size()) > CAM_GOP_CACHE_MAX_BYTES) {
+        this->gop_cache.clear();
+        this->gop_cache_bytes = 0;
         return;
     }
-    char IPv4[16]{0};
-    fprintf(stdout,
-            "Connection from %s:%d\n",
-            inet_ntop(AF_INET, &cliAddr.sin_addr, IPv4, sizeof(IPv4)),
-            ntohs(cliAddr.sin_port));
-
-    this->serve_client(cli_sockfd,               cliAddr,
-                       this->server_rtp_sock_fd, ssrcNum,
-                       sessionID,                timeout, fps);
-    //}
+    this->gop_cache.push_back(item);
+    this->gop_cache_bytes += pkt.data.size();
 }
 
-void RTSPCam::serve_client(int clientfd,          const sockaddr_in &cliAddr,
-                           int rtpFD,             const int ssrcNum,
-                           const char *sessionID, const int timeout,
-                           const float fps)
+int64_t RTSPCam::send_gop_burst()
 {
-    char method[10]{0};
-    char url[100]{0};
-    char version[10]{0};
-    char line[500]{0};
-    int cseq;
-    int64_t heartbeatCount = 0;
-    char recvBuf[1024]{0}, sendBuf[1024]{0};
-
-    while (true)
-    {
-        auto recvLen = recv(clientfd, recvBuf, sizeof(recvBuf), 0);
-        if (recvLen <= 0)
-            break;
-        recvBuf[recvLen] = 0;
-        fprintf(stdout, "--------------- [C->S] --------------\n");
-        fprintf(stdout, "%s", recvBuf);
-
-        char *bufferPtr = Utils::line_parser(recvBuf, line);
-        if (sscanf(line, "%s %s %s\r\n", method, url, version) != 3) {
-            fprintf(stdout, "RTSP::line_parser() parse method error\n");
-            break;
+    // 세션마다 한 번에 한 프레임씩, 실시간의 CAM_GOP_BURST_SPEED배 간격으로 보낸다.
+    // 라이브 프레임의 pacing을 흩뜨리지 않도록 따라잡는 세션에만 바로 보낸다
+    const int64_t now = EventLoop::now_ns();
+    for (auto it = this->gop_bursts.begin(); it != this->gop_bursts.end();) {
+        auto session = this->sessions.find(it->first);
+        if (session == this->sessions.end() || session->second->state != SessionState::PLAYING) {
+            it = this->gop_bursts.erase(it);
+            continue;
         }
-
-        char *cseqPtr = strstr(recvBuf, "CSeq:");
-        if (cseqPtr == nullptr || sscanf(cseqPtr, "CSeq: %d", &cseq) != 1) {
-            fprintf(stdout, "RTSP::line_parser() parse seq error\n");
-            break;
+        std::deque<EncodedItem> &burst = it->second;
+        if (!burst.empty()) {
+            const EncodedItem &item = burst.front();
+            this->push_item(*session->second, item);
+            this->flush_session(*session->second);
+            burst.pop_front();
         }
-
-        if (!strcmp(method, "SETUP")) {
-            char *transPtr = strstr(recvBuf, "Transport:");
-            if (transPtr == nullptr) {
-                fprintf(stderr, "RTSP::line_parser() Transport parse error\n");
-                break;
-            }
-            sscanf(transPtr,
-                   "Transport: RTP/AVP/UDP;unicast;client_port=%d-%d\r\n",
-                   &this->client_rtp_port,
-                   &this->client_rtcp_port);
-        }
-
-        if (!strcmp(method, "OPTIONS")) {
-            RequestHandler::replyCmd_OPTIONS(sendBuf, sizeof(sendBuf), cseq);
-        } else if (!strcmp(method, "DESCRIBE")) {
-            RequestHandler::replyCmd_DESCRIBE(sendBuf, sizeof(sendBuf), cseq, url);
-        } else if (!strcmp(method, "SETUP")) {
-            RequestHandler::replyCmd_SETUP(sendBuf, sizeof(sendBuf),
-                                           cseq,    this->client_rtp_port,
-                                           ssrcNum, sessionID,             timeout);
-        } else if (!strcmp(method, "PLAY")) {
-            RequestHandler::replyCmd_PLAY(sendBuf, sizeof(sendBuf),
-                                          cseq,    sessionID,       timeout);
+        if (burst.empty()) {
+            printf("GOP cache: viewer caught up with live stream\n");
+            it = this->gop_bursts.erase(it);
         } else {
-            fprintf(stderr, "Parse method error\n");
-            break;
-        }
-
-        fprintf(stdout, "--------------- [S->C] --------------\n");
-        fprintf(stdout, "%s", sendBuf);
-        if (send(clientfd, sendBuf, strlen(sendBuf), 0) < 0) {
-            fprintf(stderr, "RTSP::serve_client() send() failed: %s\n", strerror(errno));
-            break;
-        }
-
-        if (!strcmp(method, "PLAY")) {
-            char IPv4[16]{0};
-            inet_ntop(AF_INET, &cliAddr.sin_addr, IPv4, sizeof(IPv4));
-
-            struct sockaddr_in clientSock{};
-            bzero(&clientSock, sizeof(sockaddr_in));
-            clientSock.sin_family = AF_INET;
-            inet_pton(clientSock.sin_family, IPv4, &clientSock.sin_addr);
-            clientSock.sin_port = htons(this->client_rtp_port);
-
-            fprintf(stdout,
-                    "start send stream to %s:%d\n",
-                    IPv4, ntohs(clientSock.sin_port));
-
-            const auto timeStampStep = uint32_t(90000 / fps);
-            const auto sleepPeriod = uint32_t(1000 * 1000 / fps);
-            RtpHeader rtpHeader(0, 0, ssrcNum);
-            RtpPacket rtpPack{rtpHeader};
-
-            const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_H264);
-            if (!codec) {
-                fprintf(stderr, "Cannot find H.264 Codec\n");
-                return;
-            }
-
-            AVCodecContext *c = avcodec_alloc_context3(codec);
-            if (!c) {
-                fprintf(stderr, "Failed to allocate codec context.\n");
-                return;
-            }
-
-            c->bit_rate = 400000;
-            c->width = WIDTH;
-            c->height = HEIGHT;
-            c->time_base = {1, 30};
-            c->framerate = {30, 1};
-            c->gop_size = 30;
-            c->max_b_frames = 0;
-            c->pix_fmt = AV_PIX_FMT_YUV420P;
-
-            if (avcodec_open2(c, codec, NULL) < 0) {
-                fprintf(stderr, "Failed to open codec.\n");
-                avcodec_free_context(&c);
-                return;
-            }
-
-            FILE *f = fopen(OUTPUT_FILENAME, "wb");
-            if (!f) {
-                perror("Failed to open output file");
-                avcodec_free_context(&c);
-                return;
-            }
-
-            AVFrame *frame = av_frame_alloc();
-            if (!frame) {
-                fprintf(stderr, "Failed to allocate frame.\n");
-                fclose(f);
-                avcodec_free_context(&c);
-                return;
-            }
-
-            frame->format = c->pix_fmt;
-            frame->width = c->width;
-            frame->height = c->height;
-
-            if (av_image_alloc(frame->data,
-                               frame->linesize,
-                               c->width,
-                               c->height,
-                               c->pix_fmt, 32) < 0)
-            {
-                fprintf(stderr, "Failed to allocate image buffer.\n");
-                av_frame_free(&frame);
-                fclose(f);
-                avcodec_free_context(&c);
-                return;
-            }
-
-            AVPacket *pkt = av_packet_alloc();
-            if (!pkt) {
-                fprintf(stderr, "Failed to allocate packet.\n");
-                av_freep(&frame->data[0]);
-                av_frame_free(&frame);
-                fclose(f);
-                avcodec_free_context(&c);
-                return;
-            }
-
-            printf("H.264 encoding & streaming started\n");
-
-            while (true) {
-                YUV420Frame capframe;
-                // 큐에서 프레임을 가져옴
-                {
-                    std::unique_lock<std::mutex> lock(queue_mutex);
-                    queue_cond.wait(lock, [this] { return !frame_queue.empty(); });
-                    capframe = frame_queue.front();
-                    frame_queue.pop();
-                }
-
-
-                // 프레임 데이터를 RTP 전송에 맞게 설정
-                for (int y = 0; y < HEIGHT; y++) {
-                    memcpy(frame->data[0] + y * frame->linesize[0],
-                        capframe.y_data.data() + y * WIDTH, WIDTH);
-                }
-
-                int chroma_height = HEIGHT / 2;
-                int chroma_width = WIDTH / 2;
-                for (int y = 0; y < chroma_height; y++) {
-                    memcpy(frame->data[1] + y * frame->linesize[1],
-                        capframe.u_data.data() + y * chroma_width, chroma_width);
-                    memcpy(frame->data[2] + y * frame->linesize[2],
-                        capframe.v_data.data() + y * chroma_width, chroma_width);
-                }
-
-                // RTP 패킷 전송
-                frame->pts = this->pts; // PTS 설정
-                this->pts++;
-
-                if (avcodec_send_frame(c, frame) < 0) {
-                    fprintf(stderr, "Failed to send frame\n");
-                }
-
-                while (avcodec_receive_packet(c, pkt) == 0) {
-                    fwrite(pkt->data, 1, pkt->size, f);
-
-                    const int64_t start_code_len
-                        = H264Parser::is_start_code(pkt->data,pkt->size, 4) ? 4 : 3;
-                    RTSPCam::push_stream(rtpFD,
-                                         rtpPack,
-                                         pkt->data + start_code_len,
-                                         pkt->size - start_code_len,
-                                         (sockaddr *)&clientSock,
-                                         timeStampStep);
-                    av_packet_unref(pkt);
-                }
-                //std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                usleep(sleepPeriod);
-            }
-            fclose(f);
-            av_packet_free(&pkt);
-            av_freep(&frame->data[0]);
-            av_frame_free(&frame);
-            avcodec_free_context(&c);
-            break;
+            ++it;
         }
     }
-    fprintf(stdout, "finish\n");
-    close(clientfd);
+    if (this->gop_bursts.empty())
+        return 0;
+    return now + int64_t(1000 * 1000 * 1000 / (this->fps * CAM_GOP_BURST_SPEED));
 }
 
-int64_t RTSPCam::push_stream(int sockfd,          RtpPacket &rtpPack,
-                             const uint8_t *data, const int64_t dataSize,
-                             const sockaddr *to,  const uint32_t timeStampStep)
+void RTSPCam::record_loop()
 {
-    const uint8_t naluHeader = data[0];
-    if (dataSize <= MAX_RTP_DATA_SIZE) {
-        rtpPack.load_data(data, dataSize);
-        auto ret = rtpPack.rtp_sendto(sockfd,
-                                      dataSize + RTP_HEADER_SIZE,
-                                      0, to, timeStampStep);
-        if (ret < 0)
-            fprintf(stderr, "RTP_Packet::rtp_sendto() failed: %s\n", strerror(errno));
-        return ret;
-    }
-
-    const int64_t packetNum = dataSize / MAX_RTP_DATA_SIZE;
-    const int64_t remainPacketSize = dataSize % MAX_RTP_DATA_SIZE;
-    int64_t pos = 1;
-    int64_t sentBytes = 0;
-    auto payload = rtpPack.get_payload();
-    for (int64_t i = 0; i < packetNum; i++) {
-        rtpPack.load_data(data + pos, MAX_RTP_DATA_SIZE, FU_SIZE);
-        payload[0] = (naluHeader & NALU_F_NRI_MASK) | SET_FU_A_MASK;
-        payload[1] = naluHeader & NALU_TYPE_MASK;
-        if (!i)
-            payload[1] |= FU_S_MASK;
-        else if (i == packetNum - 1 && remainPacketSize == 0)
-            payload[1] |= FU_E_MASK;
-
-        auto ret = rtpPack.rtp_sendto(sockfd, MAX_RTP_PACKET_LEN, 0, to, timeStampStep);
-        if (ret < 0) {
-            fprintf(stderr, "RTP_Packet::rtp_sendto() failed: %s\n", strerror(errno));
-            return -1;
+    EncodedItem item;
+    int64_t depth = 0;
+    while (this->record_queue.pop(item, &depth)) {
+        const int64_t start = EventLoop::now_ns();
+        const EncodedPacket &pkt = *item.packet;
+        if (!this->recorder.write(pkt.data.data(), pkt.data.size(), pkt.keyframe, item.enqueued_ns)) {
+            // 디스크 오류가 나면 녹화만 멈추고 송신은 계속한다
+            this->recording = false;
+            this->recorder.close();
+            return;
         }
-        sentBytes += ret;
-        pos += MAX_RTP_DATA_SIZE;
-    }
-    if (remainPacketSize > 0) {
-        rtpPack.load_data(data + pos, remainPacketSize, FU_SIZE);
-        payload[0] = (naluHeader & NALU_F_NRI_MASK) | SET_FU_A_MASK;
-        payload[1] = (naluHeader & NALU_TYPE_MASK) | FU_E_MASK;
-        auto ret = rtpPack.rtp_sendto(sockfd,
-                                      remainPacketSize + RTP_HEADER_SIZE + FU_SIZE,
-                                      0, to, timeStampStep);
-        if (ret < 0) {
-            fprintf(stderr, "RTP_Packet::rtp_sendto() failed: %s\n", strerror(errno));
-            return -1;
-        }
-        sentBytes += ret;
+
+        this->record_stats.add(start - item.enqueued_ns, EventLoop::now_ns() - start, depth);
+        if (this->record_stats.items % STAGE_REPORT_ITEMS == 0)
+            this->record_stats.print("record");
     }
-    return sentBytes;
 }
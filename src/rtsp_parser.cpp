@@ -0,0 +1,278 @@
+#include "rtsp_parser.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "common.hpp"
+
+namespace {
+
+inline char to_lower(const char ch)
+{
+    return (ch >= 'A' && ch <= 'Z') ? char(ch - 'A' + 'a') : ch;
+}
+
+inline bool is_space(const char ch)
+{
+    return ch == ' ' || ch == '\t';
+}
+
+inline bool is_alnum(const char ch)
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+// 다음 "\r\n"의 위치. 없으면 end
+const char *find_line_end(const char *pos, const char *end)
+{
+    while (pos + 1 < end) {
+        const char *cr = static_cast<const char *>(memchr(pos, '\r', end - pos - 1));
+        if (cr == nullptr)
+            return end;
+        if (cr[1] == '\n')
+            return cr;
+        pos = cr + 1;
+    }
+    return end;
+}
+
+} // namespace
+
+bool StrView::equals(const char *str) const
+{
+    const int64_t len = strlen(str);
+    return this->size == len && (len == 0 || !memcmp(this->data, str, len));
+}
+
+bool StrView::iequals(const char *str) const
+{
+    const int64_t len = strlen(str);
+    if (this->size != len)
+        return false;
+    for (int64_t i = 0; i < len; i++) {
+        if (to_lower(this->data[i]) != to_lower(str[i]))
+            return false;
+    }
+    return true;
+}
+
+int64_t StrView::find(const char *str, const int64_t from) const
+{
+    const int64_t len = strlen(str);
+    if (len == 0)
+        return std::min(from, this->size);
+    for (int64_t i = std::max<int64_t>(from, 0); i + len <= this->size; i++) {
+        const char *hit = static_cast<const char *>(memchr(this->data + i, str[0],
+                                                           this->size - len + 1 - i));
+        if (hit == nullptr)
+            return -1;
+        i = hit - this->data;
+        if (!memcmp(hit, str, len))
+            return i;
+    }
+    return -1;
+}
+
+int64_t StrView::find(const char ch, const int64_t from) const
+{
+    if (from >= this->size)
+        return -1;
+    const int64_t start = std::max<int64_t>(from, 0);
+    const char *hit = static_cast<const char *>(memchr(this->data + start, ch, this->size - start));
+    return hit ? hit - this->data : -1;
+}
+
+StrView StrView::substr(int64_t pos, int64_t len) const
+{
+    pos = std::max<int64_t>(0, std::min(pos, this->size));
+    if (len < 0 || pos + len > this->size)
+        len = this->size - pos;
+    return StrView(this->data + pos, len);
+}
+
+StrView StrView::trim() const
+{
+    int64_t begin = 0;
+    int64_t end = this->size;
+    while (begin < end && is_space(this->data[begin]))
+        begin++;
+    while (end > begin && is_space(this->data[end - 1]))
+        end--;
+    return StrView(this->data + begin, end - begin);
+}
+
+int64_t StrView::parse_int(int64_t &value) const
+{
+    int64_t pos = 0;
+    bool negative = false;
+    if (pos < this->size && (this->data[pos] == '-' || this->data[pos] == '+')) {
+        negative = this->data[pos] == '-';
+        pos++;
+    }
+    const int64_t digitsStart = pos;
+    int64_t result = 0;
+    while (pos < this->size && this->data[pos] >= '0' && this->data[pos] <= '9') {
+        // 9자리를 넘으면 int 범위를 넘을 수 있으므로 잘라 읽지 않고 실패로 본다
+        if (pos - digitsStart == 9)
+            return 0;
+        result = result * 10 + (this->data[pos] - '0');
+        pos++;
+    }
+    if (pos == digitsStart)
+        return 0;
+    value = negative ? -result : result;
+    return pos;
+}
+
+bool StrView::to_double(double &value) const
+{
+    // strtod는 inf, nan, 1e999도 받아서 호출하는 쪽의 정수 변환이 넘칠 수 있으므로 직접 읽는다
+    int64_t integer = 0;
+    const int64_t pos = this->parse_int(integer);
+    if (pos == 0 || this->data[0] == '-' || this->data[0] == '+')
+        return false;
+    double result = double(integer);
+    int64_t end = pos;
+    if (end < this->size && this->data[end] == '.') {
+        double scale = 0.1;
+        for (end++; end < this->size && this->data[end] >= '0' && this->data[end] <= '9'; end++) {
+            result += (this->data[end] - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    // "1e999", "1.2.3"처럼 숫자 뒤에 바로 이어지는 글자가 있으면 앞부분만 읽지 않는다
+    if (end < this->size && (this->data[end] == '.' || is_alnum(this->data[end])))
+        return false;
+    value = result;
+    return true;
+}
+
+StrView RtspRequest::get_header(const char *name) const
+{
+    for (int i = 0; i < this->header_count; i++) {
+        if (this->headers[i].name.iequals(name))
+            return this->headers[i].value;
+    }
+    return StrView();
+}
+
+void RtspParser::reset()
+{
+    this->scanned = 0;
+}
+
+RtspParser::Result RtspParser::parse(const char *data, const int64_t len,
+                                     RtspRequest &request, int64_t &consumed)
+{
+    if (len <= 0)
+        return Result::INCOMPLETE;
+
+    // 클라이언트가 interleaved로 보내는 RTCP: '$' channel length(2) payload
+    if (data[0] == '$') {
+        if (len < 4)
+            return Result::INCOMPLETE;
+        const int64_t frameLen = 4 + ((uint8_t(data[2]) << 8) | uint8_t(data[3]));
+        if (frameLen > len)
+            return Result::INCOMPLETE;
+        request = RtspRequest();
+        request.channel = uint8_t(data[1]);
+        request.body = StrView(data + 4, frameLen - 4);
+        consumed = frameLen;
+        this->scanned = 0;
+        return Result::INTERLEAVED;
+    }
+
+    // 빈 줄은 앞서 훑은 곳의 3바이트 앞부터 찾는다
+    const StrView buffer(data, len);
+    const int64_t headerEnd = buffer.find("\r\n\r\n", std::max<int64_t>(0, this->scanned - 3));
+    if (headerEnd < 0) {
+        this->scanned = len;
+        return Result::INCOMPLETE;
+    }
+    this->scanned = headerEnd;
+    return this->parse_request(data, headerEnd + 4, len, request, consumed);
+}
+
+RtspParser::Result RtspParser::parse_request(const char *data, const int64_t headerLen,
+                                             const int64_t len, RtspRequest &request,
+                                             int64_t &consumed)
+{
+    request = RtspRequest();
+    request.raw = StrView(data, headerLen);
+
+    // 요청 줄: METHOD SP URL SP VERSION
+    const char *end = data + headerLen - 2;
+    const char *lineEnd = find_line_end(data, end);
+    const StrView line(data, lineEnd - data);
+    const int64_t sp1 = line.find(' ');
+    const int64_t sp2 = sp1 < 0 ? -1 : line.find(' ', sp1 + 1);
+    if (sp1 <= 0 || sp2 <= sp1 + 1 || sp2 + 1 >= line.size)
+        return Result::ERROR;
+    request.method = line.substr(0, sp1);
+    request.url = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    request.version = line.substr(sp2 + 1).trim();
+
+    int64_t contentLen = 0;
+    const char *pos = lineEnd + 2;
+    while (pos < end) {
+        lineEnd = find_line_end(pos, end);
+        const StrView header(pos, lineEnd - pos);
+        pos = lineEnd + 2;
+
+        const int64_t colon = header.find(':');
+        if (colon <= 0)
+            return Result::ERROR;
+        if (request.header_count == RtspRequest::MAX_HEADERS)
+            continue;   // 나머지 헤더는 쓰지 않는다
+        RtspHeader &entry = request.headers[request.header_count++];
+        entry.name = header.substr(0, colon).trim();
+        entry.value = header.substr(colon + 1).trim();
+
+        if (entry.name.iequals("CSeq")) {
+            if (!entry.value.parse_int(request.cseq))
+                return Result::ERROR;
+        } else if (entry.name.iequals("Content-Length")) {
+            if (!entry.value.parse_int(contentLen) || contentLen < 0 ||
+                contentLen > RTSP_RECV_BUF_SIZE)
+                return Result::ERROR;
+        }
+    }
+
+    if (headerLen + contentLen > len)
+        return Result::INCOMPLETE;
+    request.body = StrView(data + headerLen, contentLen);
+    consumed = headerLen + contentLen;
+    this->scanned = 0;
+    return Result::REQUEST;
+}
+
+StrView RtspParser::get_param(const StrView value, const char *key)
+{
+    const int64_t keyLen = strlen(key);
+    int64_t pos = 0;
+    while (pos < value.size) {
+        int64_t next = value.find(';', pos);
+        if (next < 0)
+            next = value.size;
+        const StrView param = value.substr(pos, next - pos).trim();
+        if (param.size > keyLen && param.data[keyLen] == '=' &&
+            param.substr(0, keyLen).iequals(key))
+            return param.substr(keyLen + 1);
+        pos = next + 1;
+    }
+    return StrView();
+}
+
+bool RtspParser::get_param_pair(const StrView value, const char *key,
+                                int64_t &first, int64_t &second)
+{
+    const StrView param = RtspParser::get_param(value, key);
+    const int64_t len = param.parse_int(first);
+    if (len == 0)
+        return false;
+    if (len < param.size && param.data[len] == '-' && param.substr(len + 1).parse_int(second))
+        return true;
+    second = first + 1;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,967 @@
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "rtsp_server.hpp"
+#include "common.hpp"
+#include "request_handler.hpp"
+#include "utils.hpp"
+
+constexpr int RtspServer::MULTICAST_SESSION_KEY;
+
+RtspServer::~RtspServer()
+{
+    for (auto &it : this->sessions) {
+        if (it.first >= 0)
+            close(it.first);
+    }
+    if (this->pace_timer_fd >= 0)
+        this->loop.remove_timer(this->pace_timer_fd);
+    close(this->server_rtcp_sock_fd);
+    close(this->server_rtp_sock_fd);
+    close(this->server_rtsp_sock_fd);
+}
+
+void RtspServer::init(const int ssrcNum, const char *sessionID,
+                      const int timeout, const float fps)
+{
+    this->ssrcNum = ssrcNum;
+    this->rtxSsrcNum = ssrcNum + 1;
+    this->session_prefix = sessionID;
+    this->timeout = timeout;
+    this->fps = fps;
+    if (this->sdp_media.empty())
+        this->set_parameter_sets(nullptr, 0, nullptr, 0);
+    if (this->multicast_addr.sin_family != AF_INET &&
+        !this->set_multicast(MULTICAST_DEFAULT_GROUP, MULTICAST_DEFAULT_PORT, MULTICAST_DEFAULT_TTL))
+        exit(EXIT_FAILURE);
+
+    this->server_rtsp_sock_fd = Utils::Socket(AF_INET, SOCK_STREAM);
+    if (!Utils::Bind(this->server_rtsp_sock_fd, "0.0.0.0", SERVER_RTSP_PORT)) {
+        fprintf(stderr, "failed to create RTSP socket: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    if (!Utils::Listen(this->server_rtsp_sock_fd, RTSP_LISTEN_QUEUE) ||
+        !Utils::SetNonBlocking(this->server_rtsp_sock_fd))
+        exit(EXIT_FAILURE);
+
+    this->server_rtp_sock_fd = Utils::Socket(AF_INET, SOCK_DGRAM);
+    if (!Utils::Bind(this->server_rtp_sock_fd, "0.0.0.0", SERVER_RTP_PORT)) {
+        fprintf(stderr, "failed to create RTP socket: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    this->server_rtcp_sock_fd = Utils::Socket(AF_INET, SOCK_DGRAM);
+    if (!Utils::Bind(this->server_rtcp_sock_fd, "0.0.0.0", SERVER_RTCP_PORT)) {
+        fprintf(stderr, "failed to create RTCP socket: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    if (!Utils::SetNonBlocking(this->server_rtcp_sock_fd))
+        exit(EXIT_FAILURE);
+    this->loop.add(this->server_rtcp_sock_fd, EPOLLIN, [this](uint32_t) {
+        this->read_rtcp();
+    });
+    if (this->loop.add_timer(RTCP_SR_INTERVAL_MS * 1000 * 1000,
+                             [this]() { this->send_sender_reports(); }) < 0)
+        exit(EXIT_FAILURE);
+
+    this->session_wheel.start(EventLoop::now_ns());
+    if (this->timeout > 0 &&
+        this->loop.add_timer(RTSP_SESSION_TICK_MS * 1000 * 1000,
+                             [this]() { this->reap_sessions(); }) < 0)
+        exit(EXIT_FAILURE);
+
+    // fq qdisc가 없거나 커널이 지원하지 않으면 사용자 공간 pacing으로 돌아간다
+    if (this->txtime && !RtpSender::enable_txtime(this->server_rtp_sock_fd))
+        this->txtime = false;
+
+    this->pace_timer_fd = this->loop.add_deadline_timer([this]() {
+        return this->send_slice();
+    });
+    if (this->pace_timer_fd < 0)
+        exit(EXIT_FAILURE);
+
+    this->loop.add(this->server_rtsp_sock_fd, EPOLLIN, [this](uint32_t) {
+        this->accept_clients();
+    });
+
+    fprintf(stdout, "rtsp://127.0.0.1:%d\n", SERVER_RTSP_PORT);
+}
+
+void RtspServer::set_mtu(const int64_t mtu)
+{
+    this->packetizer.set_mtu(mtu);
+}
+
+void RtspServer::set_send_mode(const SendMode mode)
+{
+    this->send_mode = mode;
+    for (auto &it : this->sessions)
+        it.second->sender.set_mode(mode);
+}
+
+void RtspServer::set_aggregation(const bool enabled)
+{
+    this->packetizer.set_aggregation(enabled);
+}
+
+void RtspServer::set_pacing(const int slices)
+{
+    this->pace_slices = std::max(0, slices);
+}
+
+void RtspServer::set_txtime(const bool enabled)
+{
+    this->txtime = enabled;
+    if (enabled && this->server_rtp_sock_fd >= 0 &&
+        !RtpSender::enable_txtime(this->server_rtp_sock_fd))
+        this->txtime = false;
+}
+
+bool RtspServer::set_multicast(const char *group, const uint16_t port, const int ttl)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, group, &addr.sin_addr) != 1 || !IN_MULTICAST(ntohl(addr.sin_addr.s_addr))) {
+        fprintf(stderr, "RtspServer::set_multicast() %s is not a multicast address\n", group);
+        return false;
+    }
+    if (this->multicast_members) {
+        fprintf(stderr, "RtspServer::set_multicast() multicast group is in use\n");
+        return false;
+    }
+    this->multicast_addr = addr;
+    this->multicast_ttl = ttl;
+    return true;
+}
+
+void RtspServer::set_parameter_sets(const uint8_t *sps, const int64_t spsLen,
+                                    const uint8_t *pps, const int64_t ppsLen)
+{
+    if (!this->sdp_media.empty() &&
+        this->sps.size() == size_t(spsLen) && std::equal(sps, sps + spsLen, this->sps.begin()) &&
+        this->pps.size() == size_t(ppsLen) && std::equal(pps, pps + ppsLen, this->pps.begin()))
+        return;
+
+    char sdp[RTSP_SEND_BUF_SIZE];
+    if (RequestHandler::build_SDP_media(sdp, sizeof(sdp), sps, spsLen, pps, ppsLen) < 0 &&
+        RequestHandler::build_SDP_media(sdp, sizeof(sdp), nullptr, 0, nullptr, 0) < 0)
+        return;
+    this->sps.assign(sps, sps + spsLen);
+    this->pps.assign(pps, pps + ppsLen);
+    this->sdp_media = sdp;
+}
+
+int64_t RtspServer::push_stream(RtspSession &session, const uint8_t *accessUnit,
+                                const int64_t accessUnitSize, const uint32_t timeStampStep,
+                                std::shared_ptr<const void> owner)
+{
+    H264Parser::split_nal_units(accessUnit, accessUnitSize, this->nal_units);
+    if (this->nal_units.empty())
+        return 0;
+
+    RtpPacket &rtpPack = *session.rtpPack;
+    if (session.interleaved) {
+        bool isIdr = false;
+        bool isReference = false;
+        for (const NalUnit &nal : this->nal_units) {
+            const uint8_t type = nal.data[0] & NALU_TYPE_MASK;
+            isIdr |= type == NALU_TYPE_IDR;
+            isReference |= type >= NALU_TYPE_SLICE && type <= NALU_TYPE_IDR &&
+                           (nal.data[0] & NALU_NRI_MASK);
+        }
+        if (this->should_drop_frame(session, isIdr, isReference)) {
+            session.sendStats.dropped_frames++;
+            rtpPack.set_header_timestamp(rtpPack.get_header_timestamp() + timeStampStep);
+            return 0;
+        }
+    }
+
+    // 이전 프레임을 주기 안에 다 못 보냈으면 새 프레임보다 먼저 마저 보낸다
+    RtpSender &sender = session.sender;
+    if (sender.get_pending_packets())
+        sender.flush(this->server_rtp_sock_fd, session.rtpAddr, session.sendStats);
+
+    // NACK이 오면 다시 보낼 수 있도록 UDP 패킷은 복사해 둔다
+    RtxCache *rtxCache = session.interleaved ? nullptr : &session.rtxCache;
+    if (rtxCache && !rtxCache->is_allocated())
+        rtxCache->reset(RTX_CACHE_BUDGET, RTP_HEADER_SIZE + this->packetizer.get_max_payload_size());
+
+    // 프레임의 모든 패킷을 같은 timestamp로 만든다
+    auto sink = [&sender, &session, rtxCache](RtpPacket &rtpPack, int64_t headLen,
+                                              const uint8_t *payload, int64_t payloadLen) {
+        sender.push(rtpPack.get_packet(), headLen, payload, payloadLen);
+        if (rtxCache)
+            rtxCache->store(rtpPack.get_header_seq(), rtpPack.get_packet(), headLen,
+                            payload, payloadLen);
+        rtpPack.next_seq();
+        session.rtp_packet_count++;
+        session.rtp_octet_count += headLen - RTP_HEADER_SIZE + payloadLen;
+        return headLen + payloadLen;
+    };
+    auto queuedBytes = this->packetizer.packetize_access_unit(rtpPack, this->nal_units,
+                                                              sink, &session.packStats);
+    session.last_rtp_timestamp = rtpPack.get_header_timestamp();
+    session.last_rtp_time = EventLoop::now_ns();
+    rtpPack.set_header_timestamp(rtpPack.get_header_timestamp() + timeStampStep);
+    sender.hold(std::move(owner));
+    return queuedBytes;
+}
+
+void RtspServer::flush_streams(const int64_t frameStartNs)
+{
+    const auto interval = int64_t(1000 * 1000 * 1000 / this->fps);
+    int slices = this->pace_slices;
+    if (slices == 0) {
+        int64_t maxPackets = 0;
+        for (auto &it : this->sessions) {
+            if (!it.second->interleaved)
+                maxPackets = std::max(maxPackets, it.second->sender.get_pending_packets());
+        }
+        slices = int(std::min(PACE_MAX_SLICES,
+                              std::max<int64_t>(1, (maxPackets + PACE_PACKETS_PER_SLICE - 1) /
+                                                   PACE_PACKETS_PER_SLICE)));
+    }
+
+    bool paced = false;
+    for (auto &it : this->sessions) {
+        RtspSession &session = *it.second;
+        if (!session.sender.get_pending_packets())
+            continue;
+        // TCP는 커널이 흐름을 조절하므로 바로 넘긴다
+        if (session.interleaved) {
+            session.sender.flush_interleaved(session.fd, session.rtp_channel,
+                                             session.sendBuf, session.sendStats);
+            this->update_write_interest(session);
+            continue;
+        }
+        if (this->txtime) {
+            session.sender.set_txtime(frameStartNs, interval);
+        } else if (slices > 1) {
+            paced = true;
+            continue;
+        }
+        session.sender.flush(this->server_rtp_sock_fd, session.rtpAddr, session.sendStats);
+    }
+    if (!paced)
+        return;
+
+    // 첫 조각은 지금 보내고 나머지는 pace 타이머가 frame 주기 안에 나눠 보낸다
+    this->pace_frame_start = frameStartNs;
+    this->pace_frame_slices = slices;
+    this->pace_next_slice = 0;
+    const int64_t next = this->send_slice();
+    if (next > 0)
+        this->loop.set_deadline(this->pace_timer_fd, next);
+}
+
+void RtspServer::flush_session(RtspSession &session)
+{
+    if (!session.sender.get_pending_packets())
+        return;
+    if (session.interleaved) {
+        session.sender.flush_interleaved(session.fd, session.rtp_channel,
+                                         session.sendBuf, session.sendStats);
+        this->update_write_interest(session);
+        return;
+    }
+    session.sender.flush(this->server_rtp_sock_fd, session.rtpAddr, session.sendStats);
+}
+
+int64_t RtspServer::send_slice()
+{
+    const int slice = this->pace_next_slice++;
+    if (slice >= this->pace_frame_slices)
+        return 0;
+
+    for (auto &it : this->sessions) {
+        RtspSession &session = *it.second;
+        if (!session.sender.get_pending_packets())
+            continue;
+        const int64_t count = session.sender.get_packet_count();
+        const int64_t target = (count * (slice + 1) + this->pace_frame_slices - 1) / this->pace_frame_slices;
+        session.sender.flush_until(this->server_rtp_sock_fd, session.rtpAddr,
+                                   session.sendStats, target);
+    }
+
+    if (slice + 1 >= this->pace_frame_slices)
+        return 0;
+    const auto interval = int64_t(1000 * 1000 * 1000 / this->fps);
+    return this->pace_frame_start + interval * (slice + 1) / this->pace_frame_slices;
+}
+
+void RtspServer::on_play(RtspSession & /*session*/)
+{
+}
+
+void RtspServer::on_keyframe_needed(RtspSession & /*session*/)
+{
+}
+
+void RtspServer::on_receiver_report(RtspSession & /*session*/)
+{
+}
+
+double RtspServer::on_seek(RtspSession & /*session*/, double /*npt*/)
+{
+    return 0;
+}
+
+void RtspServer::on_close(RtspSession & /*session*/)
+{
+}
+
+void RtspServer::accept_clients()
+{
+    while (true) {
+        sockaddr_in cliAddr{};
+        socklen_t addrLen = sizeof(cliAddr);
+        auto cli_sockfd = accept4(this->server_rtsp_sock_fd,
+                                  reinterpret_cast<sockaddr *>(&cliAddr),
+                                  &addrLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cli_sockfd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                fprintf(stderr, "accept error(): %s\n", strerror(errno));
+            return;
+        }
+
+        char IPv4[16]{0};
+        fprintf(stdout,
+                "Connection from %s:%d\n",
+                inet_ntop(AF_INET, &cliAddr.sin_addr, IPv4, sizeof(IPv4)),
+                ntohs(cliAddr.sin_port));
+
+        RtspSession *session = new RtspSession(cli_sockfd, cliAddr);
+        this->sessions[cli_sockfd].reset(session);
+        session->sender.set_mode(this->send_mode);
+        // SETUP 전의 연결도 timeout 동안 아무것도 보내지 않으면 끊는다
+        session->serial = ++this->next_session_serial;
+        session->last_active_ns = EventLoop::now_ns();
+        if (this->timeout > 0)
+            this->session_wheel.add(cli_sockfd, session->serial,
+                                    session->last_active_ns + this->timeout * 1000000000LL);
+        auto ok = this->loop.add(cli_sockfd, EPOLLIN | EPOLLRDHUP,
+                                 [this, cli_sockfd](uint32_t events) {
+            if (events & EPOLLERR) {
+                this->close_session(cli_sockfd);
+                return;
+            }
+            if (events & EPOLLOUT)
+                this->write_client(cli_sockfd);
+            if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))
+                this->read_client(cli_sockfd);
+        });
+        if (!ok) {
+            this->sessions.erase(cli_sockfd);
+            close(cli_sockfd);
+        }
+    }
+}
+
+void RtspServer::read_client(int clientfd)
+{
+    auto it = this->sessions.find(clientfd);
+    if (it == this->sessions.end())
+        return;
+    RtspSession &session = *it->second;
+
+    RtspRequest request;
+    while (true) {
+        const int64_t freeSpace = sizeof(session.recvBuf) - session.recvLen;
+        if (freeSpace <= 0) {
+            fprintf(stderr, "RtspServer::read_client() request too large\n");
+            this->close_session(clientfd);
+            return;
+        }
+
+        auto recvLen = recv(clientfd, session.recvBuf + session.recvLen, freeSpace, 0);
+        if (recvLen == 0) {
+            this->close_session(clientfd);
+            return;
+        }
+        if (recvLen < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            fprintf(stderr, "RtspServer::read_client() recv() failed: %s\n", strerror(errno));
+            this->close_session(clientfd);
+            return;
+        }
+        session.recvLen += recvLen;
+        session.last_active_ns = EventLoop::now_ns();
+
+        // 한 번의 recv에 여러 요청이 들어오거나 요청이 잘려서 들어올 수 있다.
+        // 다 처리한 뒤 남은 부분만 한 번 앞으로 당긴다
+        int64_t pos = 0;
+        while (pos < session.recvLen) {
+            int64_t consumed = 0;
+            const auto result = session.parser.parse(session.recvBuf + pos, session.recvLen - pos,
+                                                     request, consumed);
+            if (result == RtspParser::Result::INCOMPLETE)
+                break;
+            if (result == RtspParser::Result::ERROR) {
+                fprintf(stderr, "RtspServer::read_client() malformed request\n");
+                this->close_session(clientfd);
+                return;
+            }
+            if (result == RtspParser::Result::INTERLEAVED) {
+                if (session.interleaved && request.channel == session.rtcp_channel)
+                    this->handle_rtcp(session, reinterpret_cast<const uint8_t *>(request.body.data),
+                                      request.body.size);
+            } else if (!this->handle_request(session, request)) {
+                this->close_session(clientfd);
+                return;
+            }
+            pos += consumed;
+        }
+        if (pos > 0) {
+            memmove(session.recvBuf, session.recvBuf + pos, session.recvLen - pos);
+            session.recvLen -= pos;
+        }
+    }
+}
+
+bool RtspServer::handle_request(RtspSession &session, const RtspRequest &request)
+{
+    char url[256]{0};
+    char sendBuf[RTSP_SEND_BUF_SIZE]{0};
+
+    fprintf(stdout, "--------------- [C->S] --------------\n");
+    fprintf(stdout, "%.*s", int(request.raw.size), request.raw.data);
+
+    if (request.url.size >= int64_t(sizeof(url))) {
+        fprintf(stdout, "RtspServer::handle_request() parse method error\n");
+        return false;
+    }
+    memcpy(url, request.url.data, request.url.size);
+
+    if (request.cseq < 0) {
+        fprintf(stdout, "RtspServer::handle_request() parse seq error\n");
+        return false;
+    }
+    const int cseq = request.cseq;
+    const StrView &method = request.method;
+
+    // Session 헤더의 세션을 찾아 timeout을 늘린다. 다른 연결의 세션이면 keepalive와 TEARDOWN만 받는다
+    RtspSession *target = &session;
+    const StrView sessionHeader = request.get_header("Session");
+    if (!sessionHeader.empty())
+        target = this->find_session(sessionHeader);
+    else if ((method.equals("PLAY") || method.equals("TEARDOWN")) && session.session_id.empty())
+        target = nullptr;
+    if (target == nullptr ||
+        (target != &session && !method.equals("GET_PARAMETER") && !method.equals("TEARDOWN")))
+    {
+        RequestHandler::replyCmd_ERROR(sendBuf, sizeof(sendBuf),
+                                       cseq,    454, "Session Not Found");
+        fprintf(stdout, "--------------- [S->C] --------------\n");
+        fprintf(stdout, "%s", sendBuf);
+        return this->send_reply(session, sendBuf, strlen(sendBuf));
+    }
+    target->last_active_ns = EventLoop::now_ns();
+
+    if (method.equals("SETUP")) {
+        const StrView transport = request.get_header("Transport");
+        int64_t first = 0;
+        int64_t second = 0;
+        // 주소와 포트는 서버가 정한 그룹을 쓴다 (RFC 2326 12.39)
+        if (transport.find("multicast") >= 0) {
+            session.multicast = true;
+        } else if (transport.find("RTP/AVP/TCP") >= 0) {
+            if (!RtspParser::get_param_pair(transport, "interleaved", first, second)) {
+                first = 0;
+                second = 1;
+            }
+            session.interleaved = true;
+            session.rtp_channel = first;
+            session.rtcp_channel = second;
+        } else if (RtspParser::get_param_pair(transport, "client_port", first, second) &&
+                   first > 0 && first < 65536 && second > 0 && second < 65536)
+        {
+            session.client_rtp_port = first;
+            session.client_rtcp_port = second;
+        } else {
+            fprintf(stderr, "RtspServer::handle_request() Transport parse error\n");
+            return false;
+        }
+    }
+
+    bool keepAlive = true;
+    if (method.equals("OPTIONS")) {
+        RequestHandler::replyCmd_OPTIONS(sendBuf, sizeof(sendBuf), cseq);
+    } else if (method.equals("DESCRIBE")) {
+        RequestHandler::replyCmd_DESCRIBE(sendBuf, sizeof(sendBuf), cseq, url,
+                                          this->sdp_media.c_str());
+    } else if (method.equals("SETUP")) {
+        char group[INET_ADDRSTRLEN]{0};
+        if (session.session_id.empty())
+            this->assign_session_id(session);
+        if (session.multicast)
+            RequestHandler::replyCmd_SETUP_MULTICAST(sendBuf,       sizeof(sendBuf),
+                                                     cseq,
+                                                     inet_ntop(AF_INET, &this->multicast_addr.sin_addr,
+                                                               group, sizeof(group)),
+                                                     ntohs(this->multicast_addr.sin_port),
+                                                     this->multicast_ttl,
+                                                     this->ssrcNum, session.session_id.c_str(),
+                                                     this->timeout);
+        else if (session.interleaved)
+            RequestHandler::replyCmd_SETUP_INTERLEAVED(sendBuf,       sizeof(sendBuf),
+                                                       cseq,          session.rtp_channel,
+                                                       this->ssrcNum, session.session_id.c_str(),
+                                                       this->timeout);
+        else
+            RequestHandler::replyCmd_SETUP(sendBuf,       sizeof(sendBuf),
+                                           cseq,          session.client_rtp_port,
+                                           this->ssrcNum, session.session_id.c_str(),
+                                           this->timeout);
+        session.state = SessionState::READY;
+    } else if (method.equals("PLAY")) {
+        double npt = -1;
+        const StrView range = request.get_header("Range");
+        const int64_t nptPos = range.find("npt=");
+        if (nptPos < 0 || !range.substr(nptPos + 4).to_double(npt) || npt < 0)
+            npt = -1;
+        const double rangeStart = this->on_seek(session, npt);
+        RequestHandler::replyCmd_PLAY(sendBuf,         sizeof(sendBuf),
+                                      cseq,            session.session_id.c_str(),
+                                      this->timeout,   rangeStart);
+    } else if (method.equals("GET_PARAMETER")) {
+        RequestHandler::replyCmd_GET_PARAMETER(sendBuf, sizeof(sendBuf),
+                                               cseq,    target->session_id.c_str());
+    } else if (method.equals("TEARDOWN")) {
+        RequestHandler::replyCmd_TEARDOWN(sendBuf, sizeof(sendBuf),
+                                          cseq,    target->session_id.c_str());
+        keepAlive = (target != &session);
+    } else {
+        fprintf(stderr, "Parse method error\n");
+        RequestHandler::replyCmd_ERROR(sendBuf, sizeof(sendBuf),
+                                       cseq,    501, "Not Implemented");
+    }
+
+    fprintf(stdout, "--------------- [S->C] --------------\n");
+    fprintf(stdout, "%s", sendBuf);
+    if (!this->send_reply(session, sendBuf, strlen(sendBuf)))
+        return false;
+
+    if (method.equals("TEARDOWN") && target != &session) {
+        fprintf(stdout, "teardown session %s\n", target->session_id.c_str());
+        this->close_session(target->fd);
+    } else if (method.equals("PLAY") && session.multicast) {
+        if (!session.multicast_joined && !this->join_multicast(session))
+            return false;
+    } else if (method.equals("PLAY") && session.state != SessionState::PLAYING) {
+        if (!session.interleaved && session.client_rtp_port < 0) {
+            fprintf(stderr, "RtspServer::handle_request() PLAY before SETUP\n");
+            return false;
+        }
+        session.rtpAddr = session.cliAddr;
+        session.rtpAddr.sin_port = htons(session.client_rtp_port);
+        session.rtpPack.reset(new RtpPacket(RtpHeader(0, 0, this->ssrcNum)));
+        session.state = SessionState::PLAYING;
+
+        char IPv4[16]{0};
+        if (session.interleaved)
+            fprintf(stdout,
+                    "start send stream to %s over RTSP connection (channel %d)\n",
+                    inet_ntop(AF_INET, &session.cliAddr.sin_addr, IPv4, sizeof(IPv4)),
+                    session.rtp_channel);
+        else
+            fprintf(stdout,
+                    "start send stream to %s:%d\n",
+                    inet_ntop(AF_INET, &session.rtpAddr.sin_addr, IPv4, sizeof(IPv4)),
+                    session.client_rtp_port);
+        this->on_play(session);
+    }
+    return keepAlive;
+}
+
+bool RtspServer::send_reply(RtspSession &session, const char *data, const int64_t dataLen)
+{
+    // 앞서 밀린 RTP가 있으면 그 뒤에 붙여야 '$' 프레임 중간에 끼어들지 않는다
+    int64_t sentLen = 0;
+    if (session.sendBuf.empty()) {
+        auto ret = send(session.fd, data, dataLen, MSG_NOSIGNAL);
+        if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            fprintf(stderr, "RtspServer::send_reply() send() failed: %s\n", strerror(errno));
+            return false;
+        }
+        sentLen = std::max<int64_t>(ret, 0);
+    }
+    session.sendBuf.insert(session.sendBuf.end(), data + sentLen, data + dataLen);
+    this->update_write_interest(session);
+    return true;
+}
+
+void RtspServer::write_client(int clientfd)
+{
+    auto it = this->sessions.find(clientfd);
+    if (it == this->sessions.end())
+        return;
+    RtspSession &session = *it->second;
+
+    // 보낸 만큼 앞을 지우면 느린 클라이언트에서 매번 버퍼 전체를 옮기므로 offset만 늘린다
+    while (session.get_send_backlog() > 0) {
+        auto ret = send(clientfd, session.sendBuf.data() + session.sendOffset,
+                        session.get_send_backlog(), MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            fprintf(stderr, "RtspServer::write_client() send() failed: %s\n", strerror(errno));
+            this->close_session(clientfd);
+            return;
+        }
+        session.sendOffset += ret;
+    }
+    if (session.get_send_backlog() == 0) {
+        session.sendBuf.clear();
+        session.sendOffset = 0;
+    } else if (session.sendOffset * 2 >= int64_t(session.sendBuf.size())) {
+        // 계속 밀려서 비지 않을 때는 보낸 부분이 절반을 넘을 때만 당긴다
+        session.sendBuf.erase(session.sendBuf.begin(), session.sendBuf.begin() + session.sendOffset);
+        session.sendOffset = 0;
+    }
+    this->update_write_interest(session);
+}
+
+void RtspServer::update_write_interest(RtspSession &session)
+{
+    // 보낼 것이 남아 있을 때만 EPOLLOUT을 기다린다
+    const bool wantWrite = !session.sendBuf.empty();
+    if (wantWrite == session.want_write)
+        return;
+    uint32_t events = EPOLLIN | EPOLLRDHUP;
+    if (wantWrite)
+        events |= EPOLLOUT;
+    if (this->loop.modify(session.fd, events))
+        session.want_write = wantWrite;
+}
+
+bool RtspServer::should_drop_frame(RtspSession &session, const bool isIdr, const bool isReference)
+{
+    const int64_t backlog = session.get_send_backlog();
+    if (session.wait_idr) {
+        if (!isIdr || backlog >= RTSP_TCP_MAX_BACKLOG)
+            return true;
+        session.wait_idr = false;
+        return false;
+    }
+    if (backlog == 0)
+        return false;
+
+    // 밀려 있으면 다른 프레임이 참조하지 않는 프레임부터 버린다
+    if (!isReference)
+        return true;
+    if (backlog < RTSP_TCP_MAX_BACKLOG)
+        return false;
+
+    // 참조 프레임을 버리면 다음 IDR 전까지는 디코딩할 수 없다
+    session.wait_idr = true;
+    this->on_keyframe_needed(session);
+    return true;
+}
+
+bool RtspServer::send_interleaved(RtspSession &session, const uint8_t channel,
+                                  const uint8_t *data, const int64_t dataLen)
+{
+    char frame[4 + RTCP_MAX_PACKET_SIZE];
+    if (dataLen > RTCP_MAX_PACKET_SIZE)
+        return false;
+    frame[0] = '$';
+    frame[1] = char(channel);
+    frame[2] = char(dataLen >> 8);
+    frame[3] = char(dataLen);
+    memcpy(frame + 4, data, dataLen);
+    return this->send_reply(session, frame, 4 + dataLen);
+}
+
+void RtspServer::read_rtcp()
+{
+    uint8_t buffer[RTCP_MAX_PACKET_SIZE];
+    while (true) {
+        sockaddr_in from{};
+        socklen_t fromLen = sizeof(from);
+        auto ret = recvfrom(this->server_rtcp_sock_fd, buffer, sizeof(buffer), 0,
+                            reinterpret_cast<sockaddr *>(&from), &fromLen);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                fprintf(stderr, "RtspServer::read_rtcp() recvfrom() failed: %s\n", strerror(errno));
+            return;
+        }
+
+        // 보낸 주소가 SETUP에서 받은 RTCP 포트와 같은 세션을 찾는다. NAT 뒤라면 IP만 맞춰 본다
+        RtspSession *matched = nullptr;
+        for (auto &it : this->sessions) {
+            RtspSession &session = *it.second;
+            if (session.interleaved || session.cliAddr.sin_addr.s_addr != from.sin_addr.s_addr)
+                continue;
+            if (session.client_rtcp_port == ntohs(from.sin_port)) {
+                matched = &session;
+                break;
+            }
+            if (!matched)
+                matched = &session;
+        }
+        // RTCP도 keepalive로 친다 (RFC 2326 12.37)
+        if (matched)
+            matched->last_active_ns = EventLoop::now_ns();
+        // multicast 구성원의 보고는 그룹으로 보낸 스트림에 대한 것이다
+        if (matched && matched->multicast) {
+            auto group = this->sessions.find(MULTICAST_SESSION_KEY);
+            matched = (group != this->sessions.end()) ? group->second.get() : nullptr;
+        }
+        if (matched)
+            this->handle_rtcp(*matched, buffer, ret);
+    }
+}
+
+void RtspServer::handle_rtcp(RtspSession &session, const uint8_t *data, const int64_t dataLen)
+{
+    std::vector<RtcpReportBlock> blocks;
+    if (!Rtcp::parse_report_blocks(data, dataLen, blocks)) {
+        fprintf(stderr, "RtspServer::handle_rtcp() malformed RTCP packet\n");
+        return;
+    }
+    const uint64_t arrival = Rtcp::ntp_now();
+    for (const RtcpReportBlock &block : blocks) {
+        if (block.ssrc != uint32_t(this->ssrcNum))
+            continue;
+        Rtcp::update_stats(session.rtcpStats, block, arrival, RTP_H264_CLOCK_RATE);
+        this->on_receiver_report(session);
+    }
+
+    std::vector<uint16_t> seqs;
+    const int64_t nacks = Rtcp::parse_nacks(data, dataLen, uint32_t(this->ssrcNum), seqs);
+    if (nacks > 0 && !session.interleaved) {
+        session.rtxStats.nacks += nacks;
+        this->retransmit(session, seqs);
+    }
+}
+
+void RtspServer::retransmit(RtspSession &session, const std::vector<uint16_t> &seqs)
+{
+    // RFC 4588: 원래 seq(OSN)를 payload 앞에 붙이고 RTX용 PT, SSRC, seq로 바꾼다.
+    // timestamp와 marker는 원래 패킷 그대로 둔다
+    uint8_t buffer[RTP_HEADER_SIZE + 2 + MAX_RTP_DATA_SIZE];
+    for (const uint16_t seq : seqs) {
+        session.rtxStats.requested++;
+        int64_t len = 0;
+        const uint8_t *packet = session.rtxCache.find(seq, len);
+        if (packet == nullptr) {
+            session.rtxStats.misses++;
+            continue;
+        }
+
+        memcpy(buffer, packet, RTP_HEADER_SIZE);
+        buffer[1] = (packet[1] & 0x80) | RTP_PAYLOAD_TYPE_RTX;
+        const uint16_t rtxSeq = htons(session.rtx_seq++);
+        memcpy(buffer + 2, &rtxSeq, sizeof(rtxSeq));
+        const uint32_t rtxSsrc = htonl(uint32_t(this->rtxSsrcNum));
+        memcpy(buffer + 8, &rtxSsrc, sizeof(rtxSsrc));
+        memcpy(buffer + RTP_HEADER_SIZE, packet + 2, 2);
+        memcpy(buffer + RTP_HEADER_SIZE + 2, packet + RTP_HEADER_SIZE, len - RTP_HEADER_SIZE);
+
+        if (sendto(this->server_rtp_sock_fd, buffer, len + 2, 0,
+                   reinterpret_cast<const sockaddr *>(&session.rtpAddr),
+                   sizeof(session.rtpAddr)) < 0)
+        {
+            fprintf(stderr, "RtspServer::retransmit() sendto() failed: %s\n", strerror(errno));
+            return;
+        }
+        session.rtxStats.hits++;
+        session.rtxStats.bytes += len + 2;
+    }
+}
+
+void RtspServer::send_sender_reports()
+{
+    uint8_t buffer[RTCP_MAX_PACKET_SIZE];
+    const int64_t now = EventLoop::now_ns();
+    const uint64_t ntp = Rtcp::ntp_now();
+    for (auto &it : this->sessions) {
+        RtspSession &session = *it.second;
+        if (session.state != SessionState::PLAYING || !session.rtp_packet_count)
+            continue;
+
+        // 마지막 프레임 이후 흐른 시간만큼 RTP timestamp를 늘려 지금 시각에 맞춘다
+        const uint32_t rtpTimestamp = session.last_rtp_timestamp +
+            uint32_t((now - session.last_rtp_time) * RTP_H264_CLOCK_RATE / 1000000000);
+        const int64_t len = Rtcp::build_sender_report(buffer, sizeof(buffer), this->ssrcNum,
+                                                      ntp, rtpTimestamp,
+                                                      session.rtp_packet_count,
+                                                      session.rtp_octet_count, RTCP_CNAME);
+        if (len < 0)
+            continue;
+
+        if (session.interleaved) {
+            this->send_interleaved(session, session.rtcp_channel, buffer, len);
+            continue;
+        }
+        sockaddr_in to = session.cliAddr;
+        to.sin_port = htons(session.client_rtcp_port);
+        if (sendto(this->server_rtcp_sock_fd, buffer, len, 0,
+                   reinterpret_cast<sockaddr *>(&to), sizeof(to)) < 0)
+            fprintf(stderr, "RtspServer::send_sender_reports() sendto() failed: %s\n",
+                    strerror(errno));
+    }
+}
+
+void RtspServer::close_session(int clientfd)
+{
+    auto it = this->sessions.find(clientfd);
+    if (it == this->sessions.end())
+        return;
+
+    this->loop.remove(clientfd);
+    if (!it->second->session_id.empty())
+        this->session_ids.erase(it->second->session_id);
+    if (it->second->multicast_joined)
+        this->leave_multicast(*it->second);
+    this->on_close(*it->second);
+    this->print_session_stats(*it->second);
+    close(clientfd);
+    this->sessions.erase(it);
+    fprintf(stdout, "finish\n");
+}
+
+void RtspServer::assign_session_id(RtspSession &session)
+{
+    // 다른 연결에서 TEARDOWN할 수 있으므로 추측하기 어렵게 random_device로 만든다
+    char id[128];
+    do {
+        const uint64_t random = (uint64_t(this->session_random()) << 32) | this->session_random();
+        snprintf(id, sizeof(id), "%s-%016" PRIx64, this->session_prefix, random);
+    } while (this->session_ids.count(id));
+    session.session_id = id;
+    this->session_ids[session.session_id] = session.fd;
+}
+
+RtspSession *RtspServer::find_session(const StrView sessionHeader)
+{
+    // "Session: <id>;timeout=60" 처럼 뒤에 속성이 붙을 수 있다
+    int64_t idLen = sessionHeader.find(';');
+    if (idLen < 0)
+        idLen = sessionHeader.size;
+    const StrView id = sessionHeader.substr(0, idLen).trim();
+    auto it = this->session_ids.find(std::string(id.data, id.size));
+    if (it == this->session_ids.end())
+        return nullptr;
+    auto session = this->sessions.find(it->second);
+    return (session != this->sessions.end()) ? session->second.get() : nullptr;
+}
+
+void RtspServer::reap_sessions()
+{
+    // 요청을 받을 때마다 wheel을 고치지 않고, 슬롯이 돌아왔을 때 마지막 활동 시각을 보고 다시 넣는다
+    const int64_t now = EventLoop::now_ns();
+    std::vector<TimerWheelEntry> expired;
+    this->session_wheel.advance(now, expired);
+    for (const TimerWheelEntry &entry : expired) {
+        auto it = this->sessions.find(entry.key);
+        if (it == this->sessions.end() || it->second->serial != entry.token)
+            continue;   // 이미 닫힌 연결
+        RtspSession &session = *it->second;
+        const int64_t deadline = session.last_active_ns + this->timeout * 1000000000LL;
+        if (deadline > now) {
+            this->session_wheel.add(entry.key, entry.token, deadline);
+            continue;
+        }
+
+        char IPv4[16]{0};
+        fprintf(stdout, "session %s from %s timed out after %d seconds\n",
+                session.session_id.empty() ? "(none)" : session.session_id.c_str(),
+                inet_ntop(AF_INET, &session.cliAddr.sin_addr, IPv4, sizeof(IPv4)),
+                this->timeout);
+        this->close_session(entry.key);
+    }
+}
+
+void RtspServer::print_session_stats(const RtspSession &session) const
+{
+    if (session.sendStats.frames) {
+        session.sendStats.print("RTP");
+        session.packStats.print("packetizer");
+    }
+    if (session.rtcpStats.reports)
+        session.rtcpStats.print("RTCP");
+    if (session.rtxStats.nacks)
+        session.rtxStats.print("RTX");
+}
+
+bool RtspServer::join_multicast(RtspSession &session)
+{
+    char group[INET_ADDRSTRLEN]{0};
+    inet_ntop(AF_INET, &this->multicast_addr.sin_addr, group, sizeof(group));
+
+    auto it = this->sessions.find(MULTICAST_SESSION_KEY);
+    if (it != this->sessions.end()) {
+        // 이미 보내는 중이면 새 구성원이 디코딩할 수 있도록 IDR만 앞당긴다
+        session.multicast_joined = true;
+        this->multicast_members++;
+        fprintf(stdout, "join multicast group %s (%d members)\n", group, this->multicast_members);
+        this->on_keyframe_needed(*it->second);
+        return true;
+    }
+
+    if (!Utils::SetMulticastTtl(this->server_rtp_sock_fd, this->multicast_ttl) ||
+        !Utils::SetMulticastTtl(this->server_rtcp_sock_fd, this->multicast_ttl))
+        return false;
+
+    // 첫 구성원이 들어오면 그룹 세션을 만들어 스트림을 시작한다
+    std::unique_ptr<RtspSession> groupSession(new RtspSession(-1, this->multicast_addr));
+    groupSession->client_rtp_port = ntohs(this->multicast_addr.sin_port);
+    groupSession->client_rtcp_port = groupSession->client_rtp_port + 1;
+    groupSession->rtpAddr = this->multicast_addr;
+    groupSession->sender.set_mode(this->send_mode);
+    groupSession->rtpPack.reset(new RtpPacket(RtpHeader(0, 0, this->ssrcNum)));
+    groupSession->state = SessionState::PLAYING;
+    RtspSession &groupRef = *groupSession;
+    this->sessions[MULTICAST_SESSION_KEY] = std::move(groupSession);
+
+    session.multicast_joined = true;
+    this->multicast_members = 1;
+    fprintf(stdout, "start send stream to multicast group %s:%d (ttl %d)\n",
+            group, groupRef.client_rtp_port, this->multicast_ttl);
+    this->on_play(groupRef);
+    return true;
+}
+
+void RtspServer::leave_multicast(RtspSession &session)
+{
+    session.multicast_joined = false;
+    if (--this->multicast_members > 0) {
+        fprintf(stdout, "leave multicast group (%d members)\n", this->multicast_members);
+        return;
+    }
+
+    // 마지막 구성원이 나가면 그룹으로 보내는 것을 멈춘다
+    auto it = this->sessions.find(MULTICAST_SESSION_KEY);
+    if (it == this->sessions.end())
+        return;
+    it->second->state = SessionState::READY;
+    this->on_close(*it->second);
+    this->print_session_stats(*it->second);
+    this->sessions.erase(it);
+    fprintf(stdout, "stop send stream to multicast group\n");
+}
@@ -0,0 +1,58 @@
+#include "rtx_cache.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+void RtxStats::print(const char *name) const
+{
+    fprintf(stdout,
+            "[%s] nacks: %ld, requested: %ld, retransmitted: %ld, missed: %ld, bytes: %ld\n",
+            name, this->nacks, this->requested, this->hits, this->misses, this->bytes);
+}
+
+void RtxCache::reset(const int64_t budget, const int64_t slotSize)
+{
+    // seq가 16비트이므로 슬롯은 65536개를 넘지 않는다
+    int64_t slots = 1;
+    while (slots * 2 * slotSize <= budget && slots * 2 <= 65536)
+        slots *= 2;
+
+    this->slot_size = slotSize;
+    this->slot_mask = uint16_t(slots - 1);
+    this->storage.assign(slots * slotSize, 0);
+    this->lengths.assign(slots, 0);
+    this->seqs.assign(slots, 0);
+}
+
+void RtxCache::store(const uint16_t seq, const uint8_t *head, const int64_t headLen,
+                     const uint8_t *payload, const int64_t payloadLen)
+{
+    if (this->lengths.empty())
+        return;
+
+    const uint16_t slot = seq & this->slot_mask;
+    if (headLen + payloadLen > this->slot_size) {
+        // 예전 패킷을 잘못 돌려주지 않도록 비워 둔다
+        this->lengths[slot] = 0;
+        return;
+    }
+    uint8_t *dst = this->storage.data() + slot * this->slot_size;
+    memcpy(dst, head, headLen);
+    if (payloadLen)
+        memcpy(dst + headLen, payload, payloadLen);
+    this->lengths[slot] = headLen + payloadLen;
+    this->seqs[slot] = seq;
+}
+
+const uint8_t *RtxCache::find(const uint16_t seq, int64_t &len) const
+{
+    if (this->lengths.empty())
+        return nullptr;
+
+    const uint16_t slot = seq & this->slot_mask;
+    if (!this->lengths[slot] || this->seqs[slot] != seq)
+        return nullptr;
+    len = this->lengths[slot];
+    return this->storage.data() + slot * this->slot_size;
+}
@@ -0,0 +1,261 @@
+#include "segment_recorder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "event_loop.hpp"
+#include "start_code_scanner.hpp"
+#include "common.hpp"
+
+namespace {
+
+constexpr char SEGMENT_INDEX_MAGIC[8] = {'H', '2', '6', '4', 'S', 'E', 'G', '1'};
+
+#pragma pack(1)
+struct SegmentIndexHeader
+{
+    char magic[8];
+    int64_t segment;
+    int64_t frameCount;
+    int64_t fileSize;
+};
+#pragma pack()
+
+} // namespace
+
+void RecorderStats::print(const char *name) const
+{
+    fprintf(stdout,
+            "[%s] segments: %ld, frames: %ld, bytes: %ld, skipped before IDR: %ld, "
+            "writes: %ld (mean %.1f us / max %.1f us)\n",
+            name, this->segments, this->frames, this->bytes, this->skipped, this->writes,
+            this->writes ? this->write_sum / this->writes : 0.0, this->write_max);
+}
+
+SegmentRecorder::SegmentRecorder(const std::string &prefix, const int64_t maxDurationNs,
+                                 const int64_t maxBytes, const bool directIo,
+                                 const int64_t bufferSize)
+    : prefix(prefix), max_duration_ns(maxDurationNs), max_bytes(maxBytes), direct_io(directIo)
+{
+    // O_DIRECT는 주소와 크기가 모두 블록 단위로 정렬돼야 한다
+    this->buffer_size = std::max<int64_t>(1, (bufferSize + DIRECT_IO_ALIGN - 1) / DIRECT_IO_ALIGN)
+                        * DIRECT_IO_ALIGN;
+    void *mem = nullptr;
+    if (posix_memalign(&mem, DIRECT_IO_ALIGN, this->buffer_size) != 0) {
+        fprintf(stderr, "SegmentRecorder::SegmentRecorder() posix_memalign() failed\n");
+        exit(EXIT_FAILURE);
+    }
+    this->buffer = static_cast<uint8_t *>(mem);
+
+    // 녹화 스레드와 송신 스레드가 같이 쓰므로 스레드를 띄우기 전에 구현을 고정해 둔다
+    StartCodeScanner::get_impl();
+}
+
+SegmentRecorder::~SegmentRecorder()
+{
+    this->close();
+    free(this->buffer);
+}
+
+bool SegmentRecorder::write(const uint8_t *data, const int64_t size,
+                            const bool keyframe, const int64_t timeNs)
+{
+    const bool hasParameterSets = keyframe && this->scan_parameter_sets(data, size);
+
+    // 세그먼트는 IDR에서만 나눈다. 넘친 만큼은 다음 IDR까지 기다린다
+    const bool due = this->fd < 0 ||
+                     timeNs - this->segment_start_ns >= this->max_duration_ns ||
+                     this->segment_bytes >= this->max_bytes;
+    if (due && keyframe) {
+        if (this->fd >= 0 && !this->close_segment())
+            return false;
+        if (!this->open_segment(timeNs))
+            return false;
+        // 인코더가 IDR 앞에 SPS/PPS를 붙이지 않았으면 마지막으로 본 것을 먼저 쓴다
+        if (!hasParameterSets &&
+            (!this->append(this->sps.data(), this->sps.size()) ||
+             !this->append(this->pps.data(), this->pps.size())))
+            return false;
+    } else if (this->fd < 0) {
+        this->stats.skipped++;
+        return true;
+    }
+
+    SegmentIndexEntry entry;
+    entry.offset = this->segment_bytes;
+    entry.size = size;
+    entry.timeNs = timeNs - this->segment_start_ns;
+    entry.keyframe = keyframe;
+    if (!this->append(data, size))
+        return false;
+    this->entries.push_back(entry);
+    this->stats.frames++;
+    this->stats.bytes += size;
+    return true;
+}
+
+bool SegmentRecorder::close()
+{
+    if (this->fd < 0)
+        return true;
+    return this->close_segment();
+}
+
+bool SegmentRecorder::open_segment(const int64_t timeNs)
+{
+    const std::string path = this->segment_path(".h264");
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (this->direct_io) {
+        this->fd = open(path.c_str(), flags | O_DIRECT, 0644);
+        if (this->fd < 0 && errno == EINVAL) {
+            // tmpfs 등 O_DIRECT를 지원하지 않는 파일 시스템
+            fprintf(stderr, "SegmentRecorder::open_segment() O_DIRECT is not supported for %s, "
+                            "using buffered writes\n", path.c_str());
+            this->direct_io = false;
+        }
+    }
+    if (this->fd < 0)
+        this->fd = open(path.c_str(), flags, 0644);
+    if (this->fd < 0) {
+        fprintf(stderr, "SegmentRecorder::open_segment() open(%s) failed: %s\n",
+                path.c_str(), strerror(errno));
+        return false;
+    }
+
+    this->segment_start_ns = timeNs;
+    this->segment_bytes = 0;
+    this->buffer_len = 0;
+    this->entries.clear();
+    this->stats.segments++;
+    fprintf(stdout, "recording to %s%s\n", path.c_str(), this->direct_io ? " (O_DIRECT)" : "");
+    return true;
+}
+
+bool SegmentRecorder::close_segment()
+{
+    bool ok = this->flush_buffer(true);
+    if (::close(this->fd) < 0) {
+        fprintf(stderr, "SegmentRecorder::close_segment() close() failed: %s\n", strerror(errno));
+        ok = false;
+    }
+    this->fd = -1;
+    ok = this->save_index() && ok;
+    this->segment_num++;
+    return ok;
+}
+
+bool SegmentRecorder::append(const uint8_t *data, int64_t size)
+{
+    this->segment_bytes += size;
+    while (size > 0) {
+        const int64_t len = std::min(size, this->buffer_size - this->buffer_len);
+        memcpy(this->buffer + this->buffer_len, data, len);
+        this->buffer_len += len;
+        data += len;
+        size -= len;
+        if (this->buffer_len == this->buffer_size && !this->flush_buffer(false))
+            return false;
+    }
+    return true;
+}
+
+bool SegmentRecorder::flush_buffer(const bool last)
+{
+    if (this->buffer_len == 0)
+        return true;
+
+    // O_DIRECT로는 블록 단위로만 쓸 수 있으므로 마지막 조각은 0으로 채워 쓰고 나중에 잘라낸다
+    int64_t len = this->buffer_len;
+    if (this->direct_io && last) {
+        const int64_t padded = (len + DIRECT_IO_ALIGN - 1) / DIRECT_IO_ALIGN * DIRECT_IO_ALIGN;
+        memset(this->buffer + len, 0, padded - len);
+        len = padded;
+    }
+
+    const int64_t start = EventLoop::now_ns();
+    const uint8_t *pos = this->buffer;
+    while (len > 0) {
+        const ssize_t n = ::write(this->fd, pos, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "SegmentRecorder::flush_buffer() write() failed: %s\n", strerror(errno));
+            return false;
+        }
+        pos += n;
+        len -= n;
+    }
+    const double elapsed = (EventLoop::now_ns() - start) / 1000.0;
+    this->stats.writes++;
+    this->stats.write_sum += elapsed;
+    this->stats.write_max = std::max(this->stats.write_max, elapsed);
+    this->buffer_len = 0;
+
+    if (this->direct_io && last && ftruncate(this->fd, this->segment_bytes) < 0) {
+        fprintf(stderr, "SegmentRecorder::flush_buffer() ftruncate() failed: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool SegmentRecorder::save_index() const
+{
+    const std::string path = this->segment_path(".idx");
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "SegmentRecorder::save_index() fopen(%s) failed: %s\n",
+                path.c_str(), strerror(errno));
+        return false;
+    }
+
+    SegmentIndexHeader header;
+    memcpy(header.magic, SEGMENT_INDEX_MAGIC, sizeof(SEGMENT_INDEX_MAGIC));
+    header.segment = this->segment_num;
+    header.frameCount = this->entries.size();
+    header.fileSize = this->segment_bytes;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(this->entries.data(), sizeof(SegmentIndexEntry), this->entries.size(), f)
+              == this->entries.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok)
+        fprintf(stderr, "SegmentRecorder::save_index() failed: %s\n", strerror(errno));
+    return ok;
+}
+
+std::string SegmentRecorder::segment_path(const char *ext) const
+{
+    char num[32];
+    snprintf(num, sizeof(num), "_%05ld", this->segment_num);
+    return this->prefix + num + ext;
+}
+
+bool SegmentRecorder::scan_parameter_sets(const uint8_t *data, const int64_t size)
+{
+    bool hasSps = false;
+    bool hasPps = false;
+    const uint8_t *end = data + size;
+    const uint8_t *cur = StartCodeScanner::find(data, size);
+    while (cur) {
+        const uint8_t *nal = cur + ((cur[2] == 0x01) ? 3 : 4);
+        const uint8_t *next = nal < end ? StartCodeScanner::find(nal, end - nal) : nullptr;
+        const uint8_t *nalEnd = next ? next : end;
+        const uint8_t type = nal < nalEnd ? (nal[0] & NALU_TYPE_MASK) : 0;
+        if (type == NALU_TYPE_SPS) {
+            this->sps.assign(cur, nalEnd);
+            hasSps = true;
+        } else if (type == NALU_TYPE_PPS) {
+            this->pps.assign(cur, nalEnd);
+            hasPps = true;
+        }
+        cur = next;
+    }
+    return hasSps && hasPps;
+}
\ No newline at end of file
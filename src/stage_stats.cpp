@@ -0,0 +1,28 @@
+#include "stage_stats.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+void StageStats::add(const int64_t waitNs, const int64_t workNs, const int64_t depth)
+{
+    const double wait = waitNs / 1000.0;
+    const double work = workNs / 1000.0;
+    this->items++;
+    this->wait_sum += wait;
+    this->wait_max = std::max(this->wait_max, wait);
+    this->work_sum += work;
+    this->work_max = std::max(this->work_max, work);
+    this->depth_sum += depth;
+    this->depth_max = std::max(this->depth_max, depth);
+}
+
+void StageStats::print(const char *name) const
+{
+    const double n = this->items ? double(this->items) : 1;
+    fprintf(stdout,
+            "[%s] items: %ld, dropped: %ld, wait: mean %.1f us / max %.1f us, "
+            "work: mean %.1f us / max %.1f us, queue depth: mean %.2f / max %ld\n",
+            name, this->items, this->dropped, this->wait_sum / n, this->wait_max,
+            this->work_sum / n, this->work_max, this->depth_sum / n, this->depth_max);
+}
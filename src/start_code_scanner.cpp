@@ -0,0 +1,180 @@
+#include "start_code_scanner.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define START_CODE_SCANNER_X86 1
+#endif
+
+namespace {
+
+// 3바이트 start code 앞에 00이 하나 더 있으면 4바이트 start code의 시작을 돌려준다
+inline const uint8_t *adjust_start_code(const uint8_t *buffer, const int64_t pos)
+{
+    return (pos > 0 && buffer[pos - 1] == 0x00) ? buffer + pos - 1 : buffer + pos;
+}
+
+const uint8_t *scan_scalar(const uint8_t *buffer, const int64_t bufLen, int64_t pos)
+{
+    // buffer[pos + 2]만 보고 건너뛸 수 있는 만큼 건너뛴다
+    while (pos + 2 < bufLen) {
+        const uint8_t third = buffer[pos + 2];
+        if (third > 0x01) {
+            pos += 3;
+        } else if (third == 0x00) {
+            pos += 1;
+        } else {
+            if (buffer[pos] == 0x00 && buffer[pos + 1] == 0x00)
+                return adjust_start_code(buffer, pos);
+            pos += 3;
+        }
+    }
+    return nullptr;
+}
+
+const uint8_t *find_dispatch(const uint8_t *buffer, int64_t bufLen);
+
+} // namespace
+
+StartCodeScanner::FindFunc StartCodeScanner::find_func = find_dispatch;
+StartCodeScanner::Impl StartCodeScanner::impl = StartCodeScanner::Impl::SCALAR;
+
+namespace {
+
+// 첫 호출에서 CPU를 확인하고 구현을 고정한다
+const uint8_t *find_dispatch(const uint8_t *buffer, const int64_t bufLen)
+{
+    StartCodeScanner::get_impl();
+    return StartCodeScanner::find(buffer, bufLen);
+}
+
+} // namespace
+
+const uint8_t *StartCodeScanner::find_scalar(const uint8_t *buffer, const int64_t bufLen)
+{
+    return scan_scalar(buffer, bufLen, 0);
+}
+
+#ifdef START_CODE_SCANNER_X86
+
+__attribute__((target("sse2")))
+const uint8_t *StartCodeScanner::find_sse2(const uint8_t *buffer, const int64_t bufLen)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    int64_t pos = 0;
+    // buffer[pos + i], buffer[pos + i + 1], buffer[pos + i + 2]를 16바이트씩 한 번에 비교한다
+    for (; pos + 18 <= bufLen; pos += 16) {
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer + pos));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer + pos + 1));
+        const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer + pos + 2));
+        const __m128i match = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero),
+                                                          _mm_cmpeq_epi8(b1, zero)),
+                                            _mm_cmpeq_epi8(b2, one));
+        const int mask = _mm_movemask_epi8(match);
+        if (mask)
+            return adjust_start_code(buffer, pos + __builtin_ctz(mask));
+    }
+    return scan_scalar(buffer, bufLen, pos);
+}
+
+__attribute__((target("avx2")))
+const uint8_t *StartCodeScanner::find_avx2(const uint8_t *buffer, const int64_t bufLen)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    int64_t pos = 0;
+    for (; pos + 34 <= bufLen; pos += 32) {
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer + pos));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer + pos + 1));
+        const __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer + pos + 2));
+        const __m256i match = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero),
+                                                                _mm256_cmpeq_epi8(b1, zero)),
+                                               _mm256_cmpeq_epi8(b2, one));
+        const uint32_t mask = _mm256_movemask_epi8(match);
+        if (mask)
+            return adjust_start_code(buffer, pos + __builtin_ctz(mask));
+    }
+    return scan_scalar(buffer, bufLen, pos);
+}
+
+#else
+
+const uint8_t *StartCodeScanner::find_sse2(const uint8_t *buffer, const int64_t bufLen)
+{
+    return scan_scalar(buffer, bufLen, 0);
+}
+
+const uint8_t *StartCodeScanner::find_avx2(const uint8_t *buffer, const int64_t bufLen)
+{
+    return scan_scalar(buffer, bufLen, 0);
+}
+
+#endif
+
+bool StartCodeScanner::is_supported(const Impl impl)
+{
+    switch (impl) {
+    case Impl::SCALAR:
+        return true;
+#ifdef START_CODE_SCANNER_X86
+    case Impl::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case Impl::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+StartCodeScanner::Impl StartCodeScanner::detect()
+{
+    if (StartCodeScanner::is_supported(Impl::AVX2))
+        return Impl::AVX2;
+    if (StartCodeScanner::is_supported(Impl::SSE2))
+        return Impl::SSE2;
+    return Impl::SCALAR;
+}
+
+StartCodeScanner::Impl StartCodeScanner::get_impl()
+{
+    if (StartCodeScanner::find_func == find_dispatch)
+        StartCodeScanner::set_impl(StartCodeScanner::detect());
+    return StartCodeScanner::impl;
+}
+
+bool StartCodeScanner::set_impl(const Impl impl)
+{
+    if (!StartCodeScanner::is_supported(impl))
+        return false;
+
+    switch (impl) {
+    case Impl::AVX2:
+        StartCodeScanner::find_func = StartCodeScanner::find_avx2;
+        break;
+    case Impl::SSE2:
+        StartCodeScanner::find_func = StartCodeScanner::find_sse2;
+        break;
+    default:
+        StartCodeScanner::find_func = StartCodeScanner::find_scalar;
+        break;
+    }
+    StartCodeScanner::impl = impl;
+    return true;
+}
+
+const char *StartCodeScanner::impl_name(const Impl impl)
+{
+    switch (impl) {
+    case Impl::AVX2:
+        return "avx2";
+    case Impl::SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
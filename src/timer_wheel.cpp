@@ -0,0 +1,47 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+TimerWheel::TimerWheel(const int64_t tickNs, const int64_t slots)
+    : tick_ns(std::max<int64_t>(tickNs, 1)), slots(std::max<int64_t>(slots, 1))
+{
+}
+
+void TimerWheel::start(const int64_t nowNs)
+{
+    this->current_tick = nowNs / this->tick_ns;
+}
+
+void TimerWheel::add(const int key, const uint64_t token, const int64_t deadlineNs)
+{
+    // 이미 지난 deadline은 다음에 볼 슬롯에 넣는다
+    const int64_t tick = std::max(deadlineNs / this->tick_ns, this->current_tick);
+    this->slots[tick % this->slots.size()].push_back({key, token, deadlineNs});
+    this->size++;
+}
+
+void TimerWheel::advance(const int64_t nowNs, std::vector<TimerWheelEntry> &expired)
+{
+    const int64_t nowTick = nowNs / this->tick_ns;
+    // 한 바퀴 넘게 밀렸으면 모든 슬롯을 한 번씩만 본다
+    const int64_t firstTick = std::max<int64_t>(this->current_tick,
+                                                nowTick - int64_t(this->slots.size()) + 1);
+    for (int64_t tick = firstTick; tick <= nowTick; tick++) {
+        std::vector<TimerWheelEntry> &slot = this->slots[tick % this->slots.size()];
+        for (const TimerWheelEntry &entry : slot) {
+            if (entry.deadline_ns <= nowNs)
+                expired.push_back(entry);
+            else
+                this->pending.push_back(entry);
+        }
+        this->size -= slot.size();
+        slot.clear();
+    }
+    this->current_tick = nowTick + 1;
+
+    // 아직 남은 항목(다음 바퀴)은 슬롯을 다 비운 뒤에 다시 넣어야 같은 advance에서 또 보지 않는다
+    for (const TimerWheelEntry &entry : this->pending)
+        this->add(entry.key, entry.token, entry.deadline_ns);
+    this->pending.clear();
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <cstring>
 #include <iostream>
+#include <fcntl.h>
 #include <sys/ioctl.h>
 
 char *Utils::line_parser(char *src, char *line)
@@ -72,6 +73,26 @@ bool Utils::Listen(int sockfd, const int64_t ListenQueue)
     return true;
 }
 
+bool Utils::SetNonBlocking(int sockfd)
+{
+    int flags = fcntl(sockfd, F_GETFL, 0);
+    if (flags < 0 || fcntl(sockfd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        fprintf(stderr, "fcntl() failed: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool Utils::SetMulticastTtl(int sockfd, const int ttl)
+{
+    const unsigned char value = ttl;
+    if (setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &value, sizeof(value)) < 0) {
+        fprintf(stderr, "setsockopt(IP_MULTICAST_TTL) failed: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
 void Utils::xioctl(int fd, int request, void *arg)
 {
     int r;
@@ -83,4 +104,36 @@ void Utils::xioctl(int fd, int request, void *arg)
         perror("xioctl: ");
         exit(EXIT_FAILURE);
 	}
+}
+
+int64_t Utils::Base64Encode(const uint8_t *src, const int64_t srcLen, char *dst, const int64_t dstLen)
+{
+    static const char table[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    const int64_t outLen = (srcLen + 2) / 3 * 4;
+    if (dst == nullptr || outLen + 1 > dstLen)
+        return -1;
+
+    char *out = dst;
+    int64_t i = 0;
+    for (; i + 3 <= srcLen; i += 3) {
+        const uint32_t v = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+        *out++ = table[(v >> 18) & 0x3f];
+        *out++ = table[(v >> 12) & 0x3f];
+        *out++ = table[(v >> 6) & 0x3f];
+        *out++ = table[v & 0x3f];
+    }
+    // 남은 1~2바이트는 '='로 채운다
+    if (i < srcLen) {
+        uint32_t v = src[i] << 16;
+        if (i + 1 < srcLen)
+            v |= src[i + 1] << 8;
+        *out++ = table[(v >> 18) & 0x3f];
+        *out++ = table[(v >> 12) & 0x3f];
+        *out++ = (i + 1 < srcLen) ? table[(v >> 6) & 0x3f] : '=';
+        *out++ = '=';
+    }
+    *out = 0;
+    return outLen;
 }
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "frame_source.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/videodev2.h>
+
+#include "utils.hpp"
+
+V4L2Source::V4L2Source(const std::string &device) : device(device)
+{
+}
+
+V4L2Source::~V4L2Source()
+{
+    if (this->fd < 0)
+        return;
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    ioctl(this->fd, VIDIOC_STREAMOFF, &type);
+    for (const Buffer &buffer : this->buffers)
+        munmap(buffer.start, buffer.length);
+    close(this->fd);
+}
+
+void V4L2Source::init_device(const int width, const int height)
+{
+    v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+
+    Utils::xioctl(this->fd, VIDIOC_S_FMT, &fmt);
+
+    if (fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_YUYV) {
+        std::cerr << "Unsupported format." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (int(fmt.fmt.pix.width) != width || int(fmt.fmt.pix.height) != height) {
+        std::cerr << "Unsupported resolution." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Device Initialization Complete: "
+              << width << "x" << height
+              << " YUYV" << std::endl;
+}
+
+void V4L2Source::init_mmap()
+{
+    v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+
+    req.count = 6;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+
+    Utils::xioctl(this->fd, VIDIOC_REQBUFS, &req);
+
+    if (req.count < 2) {
+        std::cerr << "At least 2 buffers required for memory mapping." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    this->buffers.resize(req.count);
+    for (unsigned int i = 0; i < req.count; ++i) {
+        v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+
+        Utils::xioctl(this->fd, VIDIOC_QUERYBUF, &buf);
+
+        this->buffers[i].length = buf.length;
+        this->buffers[i].start = mmap(nullptr, buf.length,
+                                      PROT_READ | PROT_WRITE, MAP_SHARED,
+                                      this->fd, buf.m.offset);
+
+        if (this->buffers[i].start == MAP_FAILED) {
+            perror("mmap");
+            exit(EXIT_FAILURE);
+        }
+    }
+    std::cout << "Memory Mapping Complete." << std::endl;
+}
+
+bool V4L2Source::open(const int width, const int height)
+{
+    this->fd = ::open(this->device.c_str(), O_RDWR | O_NONBLOCK, 0);
+    if (this->fd == -1) {
+        perror("Failed to open video device");
+        return false;
+    }
+    this->init_device(width, height);
+    this->init_mmap();
+
+    for (unsigned int i = 0; i < this->buffers.size(); ++i) {
+        v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+
+        Utils::xioctl(this->fd, VIDIOC_QBUF, &buf);
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    Utils::xioctl(this->fd, VIDIOC_STREAMON, &type);
+
+    std::cout << "Streaming started" << std::endl;
+    return true;
+}
+
+const uint8_t *V4L2Source::read()
+{
+    v4l2_buffer buf;
+    // 지난 프레임은 다 썼으므로 드라이버에 돌려준다
+    if (this->queued_index >= 0) {
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = this->queued_index;
+        Utils::xioctl(this->fd, VIDIOC_QBUF, &buf);
+        this->queued_index = -1;
+    }
+
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    Utils::xioctl(this->fd, VIDIOC_DQBUF, &buf);
+
+    this->queued_index = buf.index;
+    return static_cast<const uint8_t *>(this->buffers[buf.index].start);
+}
+
+PixelFormat V4L2Source::get_format() const
+{
+    return PixelFormat::YUYV;
+}
+
+bool V4L2Source::is_live() const
+{
+    return true;
+}
+
+const char *V4L2Source::get_name() const
+{
+    return "v4l2";
+}
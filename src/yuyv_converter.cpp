@@ -0,0 +1,313 @@
+#include "yuyv_converter.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define YUYV_CONVERTER_X86 1
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define YUYV_CONVERTER_NEON 1
+#endif
+
+namespace {
+
+using Planes = YuyvConverter::Planes;
+
+// 두 줄(row1이 없으면 row0만)의 [x, width) 구간을 변환한다. SIMD 구현의 나머지 처리도 맡는다
+void convert_rows_scalar(const uint8_t *row0, const uint8_t *row1,
+                         uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+                         int x, const int width)
+{
+    for (; x < width; x += 2) {
+        const uint8_t *p0 = row0 + x * 2;
+        y0[x] = p0[0];
+        y0[x + 1] = p0[2];
+        if (row1 == nullptr) {
+            u[x / 2] = p0[1];
+            v[x / 2] = p0[3];
+            continue;
+        }
+        const uint8_t *p1 = row1 + x * 2;
+        y1[x] = p1[0];
+        y1[x + 1] = p1[2];
+        u[x / 2] = uint8_t((p0[1] + p1[1] + 1) >> 1);
+        v[x / 2] = uint8_t((p0[3] + p1[3] + 1) >> 1);
+    }
+}
+
+// 줄 쌍마다 rowFunc(row0, row1, y0, y1, u, v, width)를 부른다
+template <typename RowFunc>
+void convert_frame(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                   const int width, const int height, RowFunc rowFunc)
+{
+    int row = 0;
+    for (; row + 1 < height; row += 2) {
+        const uint8_t *src = yuyv + int64_t(row) * yuyvStride;
+        rowFunc(src, src + yuyvStride,
+                dst.y + int64_t(row) * dst.yStride, dst.y + int64_t(row + 1) * dst.yStride,
+                dst.u + int64_t(row / 2) * dst.uvStride, dst.v + int64_t(row / 2) * dst.uvStride,
+                width);
+    }
+    if (row < height) {
+        convert_rows_scalar(yuyv + int64_t(row) * yuyvStride, nullptr,
+                            dst.y + int64_t(row) * dst.yStride, nullptr,
+                            dst.u + int64_t(row / 2) * dst.uvStride,
+                            dst.v + int64_t(row / 2) * dst.uvStride, 0, width);
+    }
+}
+
+void rows_scalar(const uint8_t *row0, const uint8_t *row1, uint8_t *y0, uint8_t *y1,
+                 uint8_t *u, uint8_t *v, const int width)
+{
+    convert_rows_scalar(row0, row1, y0, y1, u, v, 0, width);
+}
+
+#ifdef YUYV_CONVERTER_X86
+
+// 16픽셀(32바이트)씩: 짝수 바이트가 Y, 홀수 바이트가 U V U V ...
+__attribute__((target("sse2")))
+void rows_sse2(const uint8_t *row0, const uint8_t *row1, uint8_t *y0, uint8_t *y1,
+               uint8_t *u, uint8_t *v, const int width)
+{
+    const __m128i lowMask = _mm_set1_epi16(0x00ff);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 2));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 2 + 16));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 2));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 2 + 16));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y0 + x),
+                         _mm_packus_epi16(_mm_and_si128(a0, lowMask), _mm_and_si128(b0, lowMask)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y1 + x),
+                         _mm_packus_epi16(_mm_and_si128(a1, lowMask), _mm_and_si128(b1, lowMask)));
+
+        const __m128i uv0 = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(b0, 8));
+        const __m128i uv1 = _mm_packus_epi16(_mm_srli_epi16(a1, 8), _mm_srli_epi16(b1, 8));
+        const __m128i uv = _mm_avg_epu8(uv0, uv1);
+        const __m128i zero = _mm_setzero_si128();
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(u + x / 2),
+                         _mm_packus_epi16(_mm_and_si128(uv, lowMask), zero));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(v + x / 2),
+                         _mm_packus_epi16(_mm_srli_epi16(uv, 8), zero));
+    }
+    convert_rows_scalar(row0, row1, y0, y1, u, v, x, width);
+}
+
+// 32픽셀(64바이트)씩. packus는 128비트 lane 안에서만 섞으므로 permute로 순서를 되돌린다
+__attribute__((target("avx2")))
+void rows_avx2(const uint8_t *row0, const uint8_t *row1, uint8_t *y0, uint8_t *y1,
+               uint8_t *u, uint8_t *v, const int width)
+{
+    const __m256i lowMask = _mm256_set1_epi16(0x00ff);
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row0 + x * 2));
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row0 + x * 2 + 32));
+        const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row1 + x * 2));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row1 + x * 2 + 32));
+
+        const __m256i luma0 = _mm256_packus_epi16(_mm256_and_si256(a0, lowMask),
+                                                  _mm256_and_si256(b0, lowMask));
+        const __m256i luma1 = _mm256_packus_epi16(_mm256_and_si256(a1, lowMask),
+                                                  _mm256_and_si256(b1, lowMask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(y0 + x),
+                            _mm256_permute4x64_epi64(luma0, 0xd8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(y1 + x),
+                            _mm256_permute4x64_epi64(luma1, 0xd8));
+
+        // lane 순서는 두 줄이 같으므로 평균을 낸 뒤에 한 번만 맞춘다
+        const __m256i uv0 = _mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(b0, 8));
+        const __m256i uv1 = _mm256_packus_epi16(_mm256_srli_epi16(a1, 8), _mm256_srli_epi16(b1, 8));
+        const __m256i uv = _mm256_permute4x64_epi64(_mm256_avg_epu8(uv0, uv1), 0xd8);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i uu = _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(_mm256_and_si256(uv, lowMask), zero), 0xd8);
+        const __m256i vv = _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(_mm256_srli_epi16(uv, 8), zero), 0xd8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(u + x / 2), _mm256_castsi256_si128(uu));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(v + x / 2), _mm256_castsi256_si128(vv));
+    }
+    convert_rows_scalar(row0, row1, y0, y1, u, v, x, width);
+}
+
+#endif
+
+#ifdef YUYV_CONVERTER_NEON
+
+// 32픽셀(64바이트)씩: vld4가 Y0 U Y1 V로 나눠 준다
+void rows_neon(const uint8_t *row0, const uint8_t *row1, uint8_t *y0, uint8_t *y1,
+               uint8_t *u, uint8_t *v, const int width)
+{
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const uint8x16x4_t p0 = vld4q_u8(row0 + x * 2);
+        const uint8x16x4_t p1 = vld4q_u8(row1 + x * 2);
+
+        uint8x16x2_t luma;
+        luma.val[0] = p0.val[0];
+        luma.val[1] = p0.val[2];
+        vst2q_u8(y0 + x, luma);
+        luma.val[0] = p1.val[0];
+        luma.val[1] = p1.val[2];
+        vst2q_u8(y1 + x, luma);
+
+        vst1q_u8(u + x / 2, vrhaddq_u8(p0.val[1], p1.val[1]));
+        vst1q_u8(v + x / 2, vrhaddq_u8(p0.val[3], p1.val[3]));
+    }
+    convert_rows_scalar(row0, row1, y0, y1, u, v, x, width);
+}
+
+#endif
+
+void convert_dispatch(const uint8_t *yuyv, int yuyvStride, const Planes &dst,
+                      int width, int height);
+
+} // namespace
+
+YuyvConverter::ConvertFunc YuyvConverter::convert_func = convert_dispatch;
+YuyvConverter::Impl YuyvConverter::impl = YuyvConverter::Impl::SCALAR;
+
+namespace {
+
+// 첫 호출에서 CPU를 확인하고 구현을 고정한다
+void convert_dispatch(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                      const int width, const int height)
+{
+    YuyvConverter::get_impl();
+    YuyvConverter::convert(yuyv, yuyvStride, dst, width, height);
+}
+
+} // namespace
+
+void YuyvConverter::convert_scalar(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                                   const int width, const int height)
+{
+    convert_frame(yuyv, yuyvStride, dst, width, height, rows_scalar);
+}
+
+#ifdef YUYV_CONVERTER_X86
+
+void YuyvConverter::convert_sse2(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                                 const int width, const int height)
+{
+    convert_frame(yuyv, yuyvStride, dst, width, height, rows_sse2);
+}
+
+void YuyvConverter::convert_avx2(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                                 const int width, const int height)
+{
+    convert_frame(yuyv, yuyvStride, dst, width, height, rows_avx2);
+}
+
+#else
+
+void YuyvConverter::convert_sse2(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                                 const int width, const int height)
+{
+    convert_frame(yuyv, yuyvStride, dst, width, height, rows_scalar);
+}
+
+void YuyvConverter::convert_avx2(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                                 const int width, const int height)
+{
+    convert_frame(yuyv, yuyvStride, dst, width, height, rows_scalar);
+}
+
+#endif
+
+#ifdef YUYV_CONVERTER_NEON
+
+void YuyvConverter::convert_neon(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                                 const int width, const int height)
+{
+    convert_frame(yuyv, yuyvStride, dst, width, height, rows_neon);
+}
+
+#else
+
+void YuyvConverter::convert_neon(const uint8_t *yuyv, const int yuyvStride, const Planes &dst,
+                                 const int width, const int height)
+{
+    convert_frame(yuyv, yuyvStride, dst, width, height, rows_scalar);
+}
+
+#endif
+
+bool YuyvConverter::is_supported(const Impl impl)
+{
+    switch (impl) {
+    case Impl::SCALAR:
+        return true;
+#ifdef YUYV_CONVERTER_X86
+    case Impl::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case Impl::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef YUYV_CONVERTER_NEON
+    case Impl::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+YuyvConverter::Impl YuyvConverter::detect()
+{
+    if (YuyvConverter::is_supported(Impl::AVX2))
+        return Impl::AVX2;
+    if (YuyvConverter::is_supported(Impl::SSE2))
+        return Impl::SSE2;
+    if (YuyvConverter::is_supported(Impl::NEON))
+        return Impl::NEON;
+    return Impl::SCALAR;
+}
+
+YuyvConverter::Impl YuyvConverter::get_impl()
+{
+    if (YuyvConverter::convert_func == convert_dispatch)
+        YuyvConverter::set_impl(YuyvConverter::detect());
+    return YuyvConverter::impl;
+}
+
+bool YuyvConverter::set_impl(const Impl impl)
+{
+    if (!YuyvConverter::is_supported(impl))
+        return false;
+
+    switch (impl) {
+    case Impl::AVX2:
+        YuyvConverter::convert_func = YuyvConverter::convert_avx2;
+        break;
+    case Impl::SSE2:
+        YuyvConverter::convert_func = YuyvConverter::convert_sse2;
+        break;
+    case Impl::NEON:
+        YuyvConverter::convert_func = YuyvConverter::convert_neon;
+        break;
+    default:
+        YuyvConverter::convert_func = YuyvConverter::convert_scalar;
+        break;
+    }
+    YuyvConverter::impl = impl;
+    return true;
+}
+
+const char *YuyvConverter::impl_name(const Impl impl)
+{
+    switch (impl) {
+    case Impl::AVX2:
+        return "avx2";
+    case Impl::SSE2:
+        return "sse2";
+    case Impl::NEON:
+        return "neon";
+    default:
+        return "scalar";
+    }
+}